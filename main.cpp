@@ -9,6 +9,59 @@
 #include <chrono>
 #include <thread>
 #include <string>
+#include <queue>
+#include <stack>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <deque>
+#include <array>
+#include <memory>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// x86 SIMD kernels are compiled for their instruction set per function and only called
+// after a runtime CPU check, so the rest of the program needs no -mavx2
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ALGOVIS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ALGOVIS_TARGET(isa)
+#else
+#define ALGOVIS_TARGET(isa) __attribute__((target(isa)))
+#endif
+#else
+#define ALGOVIS_X86 0
+#endif
 
 enum class AlgorithmType {
     BUBBLE_SORT,
@@ -18,807 +71,7188 @@ enum class AlgorithmType {
     MERGE_SORT,
     BFS,
     DFS,
-    DIJKSTRA
+    DIJKSTRA,
+    BOTTOM_UP_MERGE_SORT,
+    PARALLEL_MERGE_SORT,
+    PARALLEL_QUICK_SORT,
+    COUNTING_SORT,
+    RADIX_SORT,
+    BITONIC_SORT,
+    ASTAR,
+    ASTAR_OCTILE,
+    JUMP_POINT_SEARCH,
+    DIAL_DIJKSTRA,
+    BIT_BFS,
+    BIDIRECTIONAL_BFS,
+    PARALLEL_BFS
 };
 
-class AlgorithmVisualizer {
-private:
-    sf::RenderWindow window;
-    std::vector<int> data;
-    AlgorithmType currentAlgorithm;
-    bool isRunning;
-    bool isPaused;
-    int speed; // milliseconds delay
-    int arraySize;
-    int maxValue;
+struct AlgorithmInfo {
+    AlgorithmType type;
+    const char* key;  // command-line name
+    const char* name; // display name
+    bool pathfinding;
+};
+
+const AlgorithmInfo ALGORITHMS[] = {
+    {AlgorithmType::BUBBLE_SORT, "bubble", "Bubble Sort", false},
+    {AlgorithmType::INSERTION_SORT, "insertion", "Insertion Sort", false},
+    {AlgorithmType::SELECTION_SORT, "selection", "Selection Sort", false},
+    {AlgorithmType::QUICK_SORT, "quick", "Quick Sort", false},
+    {AlgorithmType::PARALLEL_QUICK_SORT, "quick-parallel", "Parallel Quick Sort", false},
+    {AlgorithmType::MERGE_SORT, "merge", "Merge Sort", false},
+    {AlgorithmType::BOTTOM_UP_MERGE_SORT, "merge-bottom-up", "Bottom-Up Merge Sort", false},
+    {AlgorithmType::PARALLEL_MERGE_SORT, "merge-parallel", "Parallel Merge Sort", false},
+    {AlgorithmType::COUNTING_SORT, "counting", "Counting Sort", false},
+    {AlgorithmType::RADIX_SORT, "radix", "Radix Sort (LSD)", false},
+    {AlgorithmType::BITONIC_SORT, "bitonic", "Bitonic Sort", false},
+    {AlgorithmType::BFS, "bfs", "Breadth-First Search", true},
+    {AlgorithmType::BIT_BFS, "bfs-bits", "Bit-Parallel BFS", true},
+    {AlgorithmType::BIDIRECTIONAL_BFS, "bfs-bidirectional", "Bidirectional BFS", true},
+    {AlgorithmType::PARALLEL_BFS, "bfs-parallel", "Parallel BFS", true},
+    {AlgorithmType::DFS, "dfs", "Depth-First Search", true},
+    {AlgorithmType::DIJKSTRA, "dijkstra", "Dijkstra's Algorithm", true},
+    {AlgorithmType::DIAL_DIJKSTRA, "dijkstra-bucket", "Dijkstra (Bucket Queue)", true},
+    {AlgorithmType::ASTAR, "astar", "A* (Manhattan)", true},
+    {AlgorithmType::ASTAR_OCTILE, "astar-octile", "A* (Octile)", true},
+    {AlgorithmType::JUMP_POINT_SEARCH, "jps", "Jump Point Search", true}
+};
+
+inline const AlgorithmInfo& algorithmInfo(AlgorithmType type) {
+    for (const auto& info : ALGORITHMS) {
+        if (info.type == type) {
+            return info;
+        }
+    }
+    return ALGORITHMS[0];
+}
+
+// Step events: algorithms run at full speed on their own copy of the input and
+// report what they did; the visualizer collects the steps and replays them afterwards
+enum class StepType : uint32_t {
+    COMPARE, // indices index() and operand were compared
+    SWAP,    // indices index() and operand were swapped
+    WRITE,   // value() was written to index()
+    VISIT,   // grid cell index() was expanded
+    PATH,    // grid cell index() lies on the final path
+    READ,    // index() was loaded into a temporary
+    PUSH,    // grid cell index() entered the frontier queue
+    POP,     // grid cell index() left the frontier queue
+    THREAD   // following steps were made by worker thread index() (0 = none)
+};
+
+// 8 bytes per step: the type sits in the top 4 bits of the header word
+struct StepEvent {
+    static const uint32_t INDEX_BITS = 28;
+    static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
     
-    // For pathfinding algorithms
-    std::vector<std::vector<int>> grid;
-    sf::Vector2i startPoint;
-    sf::Vector2i endPoint;
-    int gridSize;
+    uint32_t header;
+    uint32_t operand;
     
-    // UI elements
-    sf::Font font;
-    sf::Text algorithmText;
-    sf::Text instructionText;
+    static StepEvent make(StepType type, size_t index, uint32_t operand) {
+        return StepEvent{(static_cast<uint32_t>(type) << INDEX_BITS) | static_cast<uint32_t>(index), operand};
+    }
     
-    void initializeWindow() {
-        window.create(sf::VideoMode(1200, 800), "Algorithm Visualizer");
-        window.setFramerateLimit(60);
+    StepType type() const { return static_cast<StepType>(header >> INDEX_BITS); }
+    size_t index() const { return header & INDEX_MASK; }
+    int value() const { return static_cast<int>(operand); }
+};
+
+// Algorithms report their steps through a sink. Derived sinks provide
+// emit(const StepEvent&) and active(); the algorithms stop once active() is false.
+template <typename Derived>
+class StepSink {
+public:
+    void compare(size_t i, size_t j) {
+        self().emit(StepEvent::make(StepType::COMPARE, i, static_cast<uint32_t>(j)));
     }
     
-    void initializeFont() {
-        if (!font.loadFromFile("arial.ttf")) {
-            std::cerr << "Failed to load font!" << std::endl;
-            // Continue with default font
-        }
-        
-        algorithmText.setFont(font);
-        algorithmText.setCharacterSize(20);
-        algorithmText.setFillColor(sf::Color::White);
-        algorithmText.setPosition(10, 10);
-        
-        instructionText.setFont(font);
-        instructionText.setCharacterSize(16);
-        instructionText.setFillColor(sf::Color::White);
-        instructionText.setPosition(10, 40);
+    void swap(size_t i, size_t j) {
+        self().emit(StepEvent::make(StepType::SWAP, i, static_cast<uint32_t>(j)));
     }
     
-    void generateRandomData() {
-        data.clear();
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> distrib(10, maxValue);
-        
-        for (int i = 0; i < arraySize; i++) {
-            data.push_back(distrib(gen));
+    void write(size_t i, int value) {
+        self().emit(StepEvent::make(StepType::WRITE, i, static_cast<uint32_t>(value)));
+    }
+    
+    void visit(int cell) {
+        self().emit(StepEvent::make(StepType::VISIT, cell, 0));
+    }
+    
+    void path(int cell) {
+        self().emit(StepEvent::make(StepType::PATH, cell, 0));
+    }
+    
+    void read(size_t i) {
+        self().emit(StepEvent::make(StepType::READ, i, 0));
+    }
+    
+    void push(int cell) {
+        self().emit(StepEvent::make(StepType::PUSH, cell, 0));
+    }
+    
+    void pop(int cell) {
+        self().emit(StepEvent::make(StepType::POP, cell, 0));
+    }
+    
+    void thread(size_t id) {
+        self().emit(StepEvent::make(StepType::THREAD, id, 0));
+    }
+    
+private:
+    Derived& self() { return static_cast<Derived&>(*this); }
+};
+
+// Discards every step; used when only the algorithm's own cost should be measured
+class NullSink : public StepSink<NullSink> {
+public:
+    void emit(const StepEvent&) {}
+    bool active() const { return true; }
+};
+
+// Lets algorithms skip per-element bookkeeping whose only purpose is to emit steps
+template <typename Sink>
+struct RecordsSteps {
+    static const bool value = true;
+};
+
+template <>
+struct RecordsSteps<NullSink> {
+    static const bool value = false;
+};
+
+// Operation counts derived from a stream of steps. A compare reads two
+// elements and a swap reads and writes two.
+struct OpCounters {
+    uint64_t comparisons = 0;
+    uint64_t swaps = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t pushes = 0;
+    uint64_t pops = 0;
+    uint64_t visits = 0;
+    uint64_t pathCells = 0;
+    
+    void count(const StepEvent& step) {
+        switch (step.type()) {
+            case StepType::COMPARE: comparisons++; reads += 2; break;
+            case StepType::SWAP: swaps++; reads += 2; writes += 2; break;
+            case StepType::WRITE: writes++; break;
+            case StepType::READ: reads++; break;
+            case StepType::PUSH: pushes++; break;
+            case StepType::POP: pops++; break;
+            case StepType::VISIT: visits++; break;
+            case StepType::PATH: pathCells++; break;
+            case StepType::THREAD: break;
         }
     }
     
-    void initializeGrid() {
-        grid.clear();
-        grid.resize(gridSize, std::vector<int>(gridSize, 0));
-        
-        // Random obstacles (1 = obstacle)
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> distrib(0, 100);
-        
-        for (int i = 0; i < gridSize; i++) {
-            for (int j = 0; j < gridSize; j++) {
-                if (distrib(gen) < 20) { // 20% chance of obstacle
-                    grid[i][j] = 1;
-                }
+    OpCounters& operator+=(const OpCounters& other) {
+        comparisons += other.comparisons;
+        swaps += other.swaps;
+        reads += other.reads;
+        writes += other.writes;
+        pushes += other.pushes;
+        pops += other.pops;
+        visits += other.visits;
+        pathCells += other.pathCells;
+        return *this;
+    }
+    
+    std::string summary(bool pathfinding) const {
+        if (pathfinding) {
+            std::string text = "Pushes " + std::to_string(pushes) + "  Pops " + std::to_string(pops) +
+                               "  Expanded " + std::to_string(visits) + "  Path " + std::to_string(pathCells);
+            if (reads > 0) {
+                text += "  Scanned " + std::to_string(reads);
             }
+            return text;
         }
-        
-        // Set start and end points
-        startPoint = sf::Vector2i(0, 0);
-        endPoint = sf::Vector2i(gridSize - 1, gridSize - 1);
-        
-        // Ensure start and end points are not obstacles
-        grid[startPoint.x][startPoint.y] = 0;
-        grid[endPoint.x][endPoint.y] = 0;
+        return "Compares " + std::to_string(comparisons) + "  Swaps " + std::to_string(swaps) +
+               "  Reads " + std::to_string(reads) + "  Writes " + std::to_string(writes);
     }
+};
+
+class CountingSink : public StepSink<CountingSink> {
+public:
+    OpCounters counters;
     
-    void drawArray() {
-        window.clear(sf::Color(30, 30, 30));
-        
-        float barWidth = static_cast<float>(window.getSize().x) / data.size();
-        float heightScale = static_cast<float>(window.getSize().y - 100) / maxValue;
-        
-        for (size_t i = 0; i < data.size(); i++) {
-            sf::RectangleShape bar(sf::Vector2f(barWidth - 1, data[i] * heightScale));
-            bar.setPosition(i * barWidth, window.getSize().y - bar.getSize().y - 50);
-            bar.setFillColor(sf::Color(100, 180, 255));
-            window.draw(bar);
+    void emit(const StepEvent& step) { counters.count(step); }
+    bool active() const { return true; }
+};
+
+// Lock-free single-producer/single-consumer ring buffer carrying steps from the
+// algorithm thread to the render thread. Capacity must be a power of two.
+class StepQueue {
+private:
+    std::vector<StepEvent> slots;
+    size_t mask;
+    
+    // Each index is written by one side only; keep them on separate cache lines
+    alignas(64) std::atomic<size_t> head; // next slot to read, advanced by the consumer
+    size_t cachedTail;                    // consumer's last view of tail
+    alignas(64) std::atomic<size_t> tail; // next slot to write, advanced by the producer
+    size_t cachedHead;                    // producer's last view of head
+    
+public:
+    explicit StepQueue(size_t capacity) :
+        slots(capacity),
+        mask(capacity - 1),
+        head(0),
+        cachedTail(0),
+        tail(0),
+        cachedHead(0)
+    {
+    }
+    
+    // Producer side: pushes as many of the events as fit and returns how many did
+    size_t push(const StepEvent* events, size_t count) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (slots.size() - (t - cachedHead) < count) {
+            cachedHead = head.load(std::memory_order_acquire);
         }
         
-        // Draw UI text
-        std::string algorithmName;
-        switch (currentAlgorithm) {
-            case AlgorithmType::BUBBLE_SORT: algorithmName = "Bubble Sort"; break;
-            case AlgorithmType::INSERTION_SORT: algorithmName = "Insertion Sort"; break;
-            case AlgorithmType::SELECTION_SORT: algorithmName = "Selection Sort"; break;
-            case AlgorithmType::QUICK_SORT: algorithmName = "Quick Sort"; break;
-            case AlgorithmType::MERGE_SORT: algorithmName = "Merge Sort"; break;
-            default: algorithmName = "Unknown Algorithm";
+        size_t n = std::min(count, slots.size() - (t - cachedHead));
+        for (size_t i = 0; i < n; i++) {
+            slots[(t + i) & mask] = events[i];
         }
         
-        algorithmText.setString(algorithmName);
-        instructionText.setString("Controls: R-Reset | Space-Play/Pause | 1-5-Algorithm Selection | +/- Speed Adjustment");
-        
-        window.draw(algorithmText);
-        window.draw(instructionText);
-        
-        window.display();
+        tail.store(t + n, std::memory_order_release);
+        return n;
     }
     
-    void drawGrid() {
-        window.clear(sf::Color(30, 30, 30));
-        
-        float cellSize = std::min(
-            static_cast<float>(window.getSize().x) / gridSize,
-            static_cast<float>(window.getSize().y - 100) / gridSize
-        );
-        
-        float offsetX = (window.getSize().x - cellSize * gridSize) / 2;
-        float offsetY = ((window.getSize().y - 100) - cellSize * gridSize) / 2 + 100;
-        
-        for (int i = 0; i < gridSize; i++) {
-            for (int j = 0; j < gridSize; j++) {
-                sf::RectangleShape cell(sf::Vector2f(cellSize - 1, cellSize - 1));
-                cell.setPosition(offsetX + i * cellSize, offsetY + j * cellSize);
-                
-                // Color based on cell state
-                if (i == startPoint.x && j == startPoint.y) {
-                    cell.setFillColor(sf::Color::Green);
-                } else if (i == endPoint.x && j == endPoint.y) {
-                    cell.setFillColor(sf::Color::Red);
-                } else if (grid[i][j] == 1) {
-                    cell.setFillColor(sf::Color(100, 100, 100)); // Obstacle
-                } else if (grid[i][j] == 2) {
-                    cell.setFillColor(sf::Color(100, 180, 255)); // Visited
-                } else if (grid[i][j] == 3) {
-                    cell.setFillColor(sf::Color(255, 255, 0)); // Path
-                } else {
-                    cell.setFillColor(sf::Color(40, 40, 40)); // Empty
-                }
-                
-                window.draw(cell);
-            }
+    // Consumer side: appends up to maxCount queued events to out and returns how many
+    size_t pop(std::vector<StepEvent>& out, size_t maxCount) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (cachedTail == h) {
+            cachedTail = tail.load(std::memory_order_acquire);
         }
         
-        // Draw UI text
-        std::string algorithmName;
-        switch (currentAlgorithm) {
-            case AlgorithmType::BFS: algorithmName = "Breadth-First Search"; break;
-            case AlgorithmType::DFS: algorithmName = "Depth-First Search"; break;
-            case AlgorithmType::DIJKSTRA: algorithmName = "Dijkstra's Algorithm"; break;
-            default: algorithmName = "Unknown Pathfinding Algorithm";
-        }
-        
-        algorithmText.setString(algorithmName);
-        instructionText.setString("Controls: R-Reset | Space-Play/Pause | 6-8-Algorithm Selection | +/- Speed Adjustment");
-        
-        window.draw(algorithmText);
-        window.draw(instructionText);
+        size_t n = std::min(cachedTail - h, maxCount);
+        size_t first = h & mask;
+        size_t firstSpan = std::min(n, slots.size() - first);
+        out.insert(out.end(), slots.begin() + first, slots.begin() + first + firstSpan);
+        out.insert(out.end(), slots.begin(), slots.begin() + (n - firstSpan));
         
-        window.display();
+        head.store(h + n, std::memory_order_release);
+        return n;
     }
     
-    void delay() {
-        std::this_thread::sleep_for(std::chrono::milliseconds(speed));
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
     }
     
-    // Sorting Algorithms
-    void bubbleSort() {
-        for (size_t i = 0; i < data.size() - 1 && isRunning && !isPaused; i++) {
-            for (size_t j = 0; j < data.size() - i - 1 && isRunning && !isPaused; j++) {
-                if (data[j] > data[j + 1]) {
-                    std::swap(data[j], data[j + 1]);
-                    drawArray();
-                    delay();
-                }
-                
-                // Handle window events
-                handleEvents();
-                
-                if (isPaused) {
-                    while (isPaused && isRunning) {
-                        handleEvents();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                    }
-                }
-            }
-        }
+    // Only valid while no producer is running
+    void clear() {
+        head.store(0);
+        tail.store(0);
+        cachedHead = 0;
+        cachedTail = 0;
     }
+};
+
+// Batches steps into a StepQueue, waiting while the render thread catches up
+class QueueSink : public StepSink<QueueSink> {
+private:
+    static const size_t BATCH = 256;
     
-    void insertionSort() {
-        for (size_t i = 1; i < data.size() && isRunning && !isPaused; i++) {
-            int key = data[i];
-            int j = i - 1;
-            
-            while (j >= 0 && data[j] > key && isRunning && !isPaused) {
-                data[j + 1] = data[j];
-                j--;
-                drawArray();
-                delay();
-                
-                // Handle window events
-                handleEvents();
-                
-                if (isPaused) {
-                    while (isPaused && isRunning) {
-                        handleEvents();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                    }
-                }
-            }
-            
-            data[j + 1] = key;
-            drawArray();
-            delay();
+    StepQueue& queue;
+    const std::atomic<bool>& cancelled;
+    StepEvent batch[BATCH];
+    size_t count;
+    
+public:
+    QueueSink(StepQueue& q, const std::atomic<bool>& cancelFlag) : queue(q), cancelled(cancelFlag), count(0) {}
+    
+    void emit(const StepEvent& event) {
+        batch[count++] = event;
+        if (count == BATCH) {
+            flush();
         }
     }
     
-    void selectionSort() {
-        for (size_t i = 0; i < data.size() - 1 && isRunning && !isPaused; i++) {
-            size_t min_idx = i;
+    bool active() const { return !cancelled.load(std::memory_order_relaxed); }
+    
+    void flush() {
+        size_t sent = 0;
+        int attempts = 0;
+        while (sent < count && active()) {
+            size_t n = queue.push(batch + sent, count - sent);
+            sent += n;
             
-            for (size_t j = i + 1; j < data.size() && isRunning && !isPaused; j++) {
-                if (data[j] < data[min_idx]) {
-                    min_idx = j;
-                }
-                
-                // Handle window events
-                handleEvents();
-                
-                if (isPaused) {
-                    while (isPaused && isRunning) {
-                        handleEvents();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                    }
+            if (n == 0) {
+                // Queue full: spin briefly, then back off so a paused consumer costs no CPU
+                if (++attempts < 64) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
                 }
-            }
-            
-            if (min_idx != i) {
-                std::swap(data[i], data[min_idx]);
-                drawArray();
-                delay();
+            } else {
+                attempts = 0;
             }
         }
+        count = 0;
     }
+};
+
+// Hardware counters sampled with perf_event_open (Linux only)
+struct PerfSample {
+    bool valid = false;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t branchMisses = 0;
     
-    void quickSort(int low, int high) {
-        if (low < high && isRunning && !isPaused) {
-            // Partition the array
-            int pivot = data[high];
-            int i = low - 1;
-            
-            for (int j = low; j <= high - 1 && isRunning && !isPaused; j++) {
-                if (data[j] < pivot) {
-                    i++;
-                    std::swap(data[i], data[j]);
-                    drawArray();
-                    delay();
-                }
-                
-                // Handle window events
-                handleEvents();
-                
-                if (isPaused) {
-                    while (isPaused && isRunning) {
-                        handleEvents();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                    }
-                }
-            }
-            
-            std::swap(data[i + 1], data[high]);
-            drawArray();
-            delay();
-            
-            int partition = i + 1;
-            
-            // Recursively sort the subarrays
-            quickSort(low, partition - 1);
-            quickSort(partition + 1, high);
+    std::string summary() const {
+        if (!valid) {
+            return "";
         }
+        double ipc = cycles ? static_cast<double>(instructions) / cycles : 0;
+        return "Cycles " + std::to_string(cycles) + "  Instructions " + std::to_string(instructions) +
+               " (IPC " + std::to_string(ipc).substr(0, 4) + ")  Cache misses " + std::to_string(cacheMisses) +
+               "  Branch misses " + std::to_string(branchMisses);
     }
+};
+
+// Counts user-space events of the thread that called open(); read() may be called from any thread
+class PerfCounters {
+private:
+    static const int EVENT_COUNT = 4;
+    int fds[EVENT_COUNT];
     
-    void merge(int left, int mid, int right) {
-        int n1 = mid - left + 1;
-        int n2 = right - mid;
-        
-        std::vector<int> leftArray(n1);
-        std::vector<int> rightArray(n2);
-        
-        for (int i = 0; i < n1; i++) {
-            leftArray[i] = data[left + i];
-        }
-        
-        for (int j = 0; j < n2; j++) {
-            rightArray[j] = data[mid + 1 + j];
-        }
-        
-        int i = 0, j = 0, k = left;
-        
-        while (i < n1 && j < n2 && isRunning && !isPaused) {
-            if (leftArray[i] <= rightArray[j]) {
-                data[k] = leftArray[i];
-                i++;
-            } else {
-                data[k] = rightArray[j];
-                j++;
-            }
-            
-            k++;
-            drawArray();
-            delay();
-            
-            // Handle window events
-            handleEvents();
-            
-            if (isPaused) {
-                while (isPaused && isRunning) {
-                    handleEvents();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-        }
-        
-        while (i < n1 && isRunning && !isPaused) {
-            data[k] = leftArray[i];
-            i++;
-            k++;
-            drawArray();
-            delay();
-            
-            handleEvents();
-            
-            if (isPaused) {
-                while (isPaused && isRunning) {
-                    handleEvents();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-        }
-        
-        while (j < n2 && isRunning && !isPaused) {
-            data[k] = rightArray[j];
-            j++;
-            k++;
-            drawArray();
-            delay();
-            
-            handleEvents();
-            
-            if (isPaused) {
-                while (isPaused && isRunning) {
-                    handleEvents();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-        }
+public:
+    PerfCounters() {
+        std::fill(fds, fds + EVENT_COUNT, -1);
     }
     
-    void mergeSort(int left, int right) {
-        if (left < right && isRunning && !isPaused) {
-            int mid = left + (right - left) / 2;
-            
-            mergeSort(left, mid);
-            mergeSort(mid + 1, right);
-            
-            merge(left, mid, right);
-        }
+    ~PerfCounters() {
+        close();
     }
     
-    // Pathfinding Algorithms
-    void bfs() {
-        std::vector<std::vector<bool>> visited(gridSize, std::vector<bool>(gridSize, false));
-        std::vector<std::vector<sf::Vector2i>> parent(gridSize, std::vector<sf::Vector2i>(gridSize, sf::Vector2i(-1, -1)));
-        
-        std::queue<sf::Vector2i> q;
-        q.push(startPoint);
-        visited[startPoint.x][startPoint.y] = true;
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    
+    bool isOpen() const { return fds[0] >= 0; }
+    
+#if defined(__linux__)
+    bool open() {
+        close();
         
-        // Directions: up, right, down, left
-        std::vector<sf::Vector2i> directions = {
-            sf::Vector2i(0, -1), sf::Vector2i(1, 0),
-            sf::Vector2i(0, 1), sf::Vector2i(-1, 0)
+        const uint64_t configs[EVENT_COUNT] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
         };
         
-        bool foundPath = false;
-        
-        while (!q.empty() && isRunning && !isPaused) {
-            sf::Vector2i current = q.front();
-            q.pop();
-            
-            if (current == endPoint) {
-                foundPath = true;
-                break;
-            }
-            
-            // Mark as visited in the grid
-            if (current != startPoint && current != endPoint) {
-                grid[current.x][current.y] = 2;
-            }
-            
-            for (const auto& dir : directions) {
-                sf::Vector2i next(current.x + dir.x, current.y + dir.y);
-                
-                // Check if next position is valid
-                if (next.x >= 0 && next.x < gridSize && next.y >= 0 && next.y < gridSize &&
-                    !visited[next.x][next.y] && grid[next.x][next.y] != 1) {
-                    
-                    q.push(next);
-                    visited[next.x][next.y] = true;
-                    parent[next.x][next.y] = current;
-                }
-            }
+        for (int i = 0; i < EVENT_COUNT; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = i == 0; // the group leader starts and stops every counter
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
             
-            drawGrid();
-            delay();
-            
-            // Handle window events
-            handleEvents();
-            
-            if (isPaused) {
-                while (isPaused && isRunning) {
-                    handleEvents();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds[0], 0));
+            if (fds[i] < 0) {
+                close();
+                return false;
             }
         }
+        return true;
+    }
+    
+    void start() {
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    
+    void stop() {
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+    
+    PerfSample read() const {
+        PerfSample sample;
+        uint64_t values[1 + EVENT_COUNT];
+        if (!isOpen() || ::read(fds[0], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values))) {
+            return sample;
+        }
         
-        // Reconstruct path
-        if (foundPath) {
-            sf::Vector2i current = endPoint;
-            while (current != startPoint) {
-                sf::Vector2i prev = parent[current.x][current.y];
-                if (prev != startPoint) {
-                    grid[prev.x][prev.y] = 3; // Path
-                }
-                current = prev;
-                
-                drawGrid();
-                delay();
+        sample.valid = true;
+        sample.cycles = values[1];
+        sample.instructions = values[2];
+        sample.cacheMisses = values[3];
+        sample.branchMisses = values[4];
+        return sample;
+    }
+    
+    void close() {
+        for (int i = EVENT_COUNT - 1; i >= 0; i--) {
+            if (fds[i] >= 0) {
+                ::close(fds[i]);
+                fds[i] = -1;
             }
         }
     }
+#else
+    bool open() { return false; }
+    void start() {}
+    void stop() {}
+    PerfSample read() const { return PerfSample(); }
+    void close() {}
+#endif
+};
+
+// Runs one algorithm job on a dedicated thread, streaming its steps through a StepQueue
+class AlgorithmWorker {
+private:
+    StepQueue queue;
+    std::thread thread;
+    std::atomic<bool> cancelled;
+    std::atomic<bool> finished;
+    double elapsedMillis; // published by finished
     
-    void dfs() {
-        std::vector<std::vector<bool>> visited(gridSize, std::vector<bool>(gridSize, false));
-        std::vector<std::vector<sf::Vector2i>> parent(gridSize, std::vector<sf::Vector2i>(gridSize, sf::Vector2i(-1, -1)));
-        
-        std::stack<sf::Vector2i> s;
-        s.push(startPoint);
-        
-        // Directions: up, right, down, left
-        std::vector<sf::Vector2i> directions = {
-            sf::Vector2i(0, -1), sf::Vector2i(1, 0),
-            sf::Vector2i(0, 1), sf::Vector2i(-1, 0)
-        };
-        
-        bool foundPath = false;
+    // Opened by the worker thread so the counters follow it; published by perfReady
+    PerfCounters perf;
+    std::atomic<bool> perfReady;
+    
+public:
+    AlgorithmWorker() : queue(1 << 20), cancelled(false), finished(false), elapsedMillis(0), perfReady(false) {}
+    
+    ~AlgorithmWorker() {
+        stop();
+    }
+    
+    // Starts job(QueueSink&) on the worker thread; the job must own its input.
+    // With samplePerf the hardware counters are sampled around the job.
+    template <typename Job>
+    void start(Job job, bool samplePerf) {
+        stop();
+        cancelled = false;
+        finished = false;
         
-        while (!s.empty() && isRunning && !isPaused) {
-            sf::Vector2i current = s.top();
-            s.pop();
-            
-            if (current == endPoint) {
-                foundPath = true;
-                break;
+        thread = std::thread([this, job, samplePerf]() mutable {
+            if (samplePerf && perf.open()) {
+                perf.start();
+                perfReady.store(true, std::memory_order_release);
             }
             
-            if (visited[current.x][current.y]) {
-                continue;
-            }
-            
-            visited[current.x][current.y] = true;
-            
-            // Mark as visited in the grid
-            if (current != startPoint && current != endPoint) {
-                grid[current.x][current.y] = 2;
-            }
-            
-            for (const auto& dir : directions) {
-                sf::Vector2i next(current.x + dir.x, current.y + dir.y);
-                
-                // Check if next position is valid
-                if (next.x >= 0 && next.x < gridSize && next.y >= 0 && next.y < gridSize &&
-                    !visited[next.x][next.y] && grid[next.x][next.y] != 1) {
-                    
-                    s.push(next);
-                    parent[next.x][next.y] = current;
-                }
-            }
-            
-            drawGrid();
-            delay();
-            
-            // Handle window events
-            handleEvents();
+            auto begin = std::chrono::steady_clock::now();
+            QueueSink sink(queue, cancelled);
+            job(sink);
+            sink.flush();
             
-            if (isPaused) {
-                while (isPaused && isRunning) {
-                    handleEvents();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
+            if (perfReady.load(std::memory_order_relaxed)) {
+                perf.stop();
             }
+            elapsedMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            finished.store(true, std::memory_order_release);
+        });
+    }
+    
+    // Cancels the running job, waits for it and discards its undelivered steps
+    void stop() {
+        if (thread.joinable()) {
+            cancelled = true;
+            thread.join();
         }
-        
-        // Reconstruct path
-        if (foundPath) {
-            sf::Vector2i current = endPoint;
-            while (current != startPoint) {
-                sf::Vector2i prev = parent[current.x][current.y];
-                if (prev != startPoint) {
-                    grid[prev.x][prev.y] = 3; // Path
+        queue.clear();
+        perfReady = false;
+        perf.close();
+    }
+    
+    size_t drain(std::vector<StepEvent>& out, size_t maxCount) {
+        return queue.pop(out, maxCount);
+    }
+    
+    bool computed() const { return finished.load(std::memory_order_acquire); }
+    
+    // True once the job has finished and every step has been drained
+    bool done() const { return computed() && queue.empty(); }
+    
+    double computeMillis() const { return computed() ? elapsedMillis : 0; }
+    
+    // Current hardware counter values of the job; invalid when sampling is off or unsupported
+    PerfSample perfSample() const {
+        return perfReady.load(std::memory_order_acquire) ? perf.read() : PerfSample();
+    }
+};
+
+// Parallel algorithms give each thread its own local sink. Recording sinks get a
+// StepBuffer whose steps are replayed into the caller's sink after the threads join;
+// the parent's active() must therefore be safe to call from several threads.
+template <typename Parent>
+class StepBuffer : public StepSink<StepBuffer<Parent>> {
+private:
+    const Parent* parent;
+    
+public:
+    std::vector<StepEvent> events;
+    
+    // Optional (ticket, first event) pairs; see beginSegment()
+    std::vector<std::pair<uint64_t, size_t>> segments;
+    
+    explicit StepBuffer(const Parent& p) : parent(&p) {}
+    
+    void emit(const StepEvent& step) { events.push_back(step); }
+    bool active() const { return parent->active(); }
+};
+
+// Starts a new segment of the thread's steps. When work moves between threads the
+// steps are replayed segment by segment in ticket order instead of interleaved, so a
+// segment's ticket must be drawn after every segment it depends on has started.
+template <typename Sink>
+void beginSegment(Sink&, uint64_t) {}
+
+template <typename Parent>
+void beginSegment(StepBuffer<Parent>& local, uint64_t ticket) {
+    local.segments.emplace_back(ticket, local.events.size());
+}
+
+template <typename Sink>
+StepBuffer<Sink> makeLocalSink(const Sink& parent) {
+    return StepBuffer<Sink>(parent);
+}
+
+inline NullSink makeLocalSink(const NullSink&) {
+    return NullSink();
+}
+
+inline CountingSink makeLocalSink(const CountingSink&) {
+    return CountingSink();
+}
+
+// Replays whole segments in ticket order, tagging each run of segments with its thread
+template <typename Sink>
+void joinSegments(std::vector<StepBuffer<Sink>>& locals, Sink& out) {
+    struct Segment {
+        uint64_t ticket;
+        size_t thread;
+        size_t begin;
+        size_t end;
+    };
+    
+    std::vector<Segment> segments;
+    for (size_t t = 0; t < locals.size(); t++) {
+        const auto& marks = locals[t].segments;
+        for (size_t s = 0; s < marks.size(); s++) {
+            size_t end = s + 1 < marks.size() ? marks[s + 1].second : locals[t].events.size();
+            segments.push_back({marks[s].first, t, marks[s].second, end});
+        }
+    }
+    std::sort(segments.begin(), segments.end(), [](const Segment& x, const Segment& y) {
+        return x.ticket < y.ticket;
+    });
+    
+    size_t current = SIZE_MAX;
+    for (const Segment& segment : segments) {
+        if (segment.begin == segment.end) {
+            continue;
+        }
+        if (segment.thread != current) {
+            current = segment.thread;
+            out.thread(current + 1);
+        }
+        for (size_t i = segment.begin; i < segment.end; i++) {
+            out.emit(locals[segment.thread].events[i]);
+        }
+    }
+    out.thread(0);
+}
+
+// Interleaves the threads' steps in small chunks, each tagged with its thread (1-based),
+// so playback shows the threads progressing side by side
+template <typename Sink>
+void joinLocalSinks(std::vector<StepBuffer<Sink>>& locals, Sink& out) {
+    // A lone thread has no one to be told apart from
+    if (locals.size() == 1) {
+        for (const StepEvent& step : locals[0].events) {
+            out.emit(step);
+        }
+        return;
+    }
+    
+    bool segmented = false;
+    for (const auto& local : locals) {
+        segmented = segmented || !local.segments.empty();
+    }
+    if (segmented) {
+        joinSegments(locals, out);
+        return;
+    }
+    
+    const size_t CHUNK = 16;
+    std::vector<size_t> cursors(locals.size(), 0);
+    bool pending = true;
+    
+    while (pending) {
+        pending = false;
+        for (size_t t = 0; t < locals.size(); t++) {
+            const std::vector<StepEvent>& events = locals[t].events;
+            if (cursors[t] >= events.size()) {
+                continue;
+            }
+            
+            out.thread(t + 1);
+            size_t end = std::min(events.size(), cursors[t] + CHUNK);
+            for (; cursors[t] < end; cursors[t]++) {
+                out.emit(events[cursors[t]]);
+            }
+            pending = true;
+        }
+    }
+    out.thread(0);
+}
+
+inline void joinLocalSinks(std::vector<NullSink>&, NullSink&) {}
+
+inline void joinLocalSinks(std::vector<CountingSink>& locals, CountingSink& out) {
+    for (const auto& local : locals) {
+        out.counters += local.counters;
+    }
+}
+
+// Upper bound on worker threads for the parallel algorithms; 0 uses every hardware thread
+inline unsigned& threadLimit() {
+    static unsigned limit = 0;
+    return limit;
+}
+
+inline unsigned parallelism(size_t n) {
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    if (threadLimit() > 0) {
+        hardware = threadLimit();
+    }
+    return static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(hardware, n / 2)));
+}
+
+// Runs task(thread, localSink) on `threads` threads (the caller acts as thread 0)
+template <typename Sink, typename Task>
+void runParallel(unsigned threads, Sink& out, Task task) {
+    std::vector<decltype(makeLocalSink(out))> locals;
+    for (unsigned t = 0; t < threads; t++) {
+        locals.push_back(makeLocalSink(out));
+    }
+    
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back([&task, &locals, t]() { task(t, locals[t]); });
+    }
+    task(0, locals[0]);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    
+    joinLocalSinks(locals, out);
+}
+
+// Reusable barrier for worker threads that stay alive across phases (e.g. BFS levels).
+// Phases are short, so waiters spin briefly and then yield instead of sleeping.
+class SpinBarrier {
+private:
+    unsigned count;
+    std::atomic<unsigned> waiting;
+    std::atomic<unsigned> generation;
+    
+public:
+    explicit SpinBarrier(unsigned count) : count(count), waiting(0), generation(0) {}
+    
+    void wait() {
+        unsigned phase = generation.load(std::memory_order_acquire);
+        if (waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            waiting.store(0, std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        for (int spin = 0; generation.load(std::memory_order_acquire) == phase; spin++) {
+            if (spin >= 64) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+// Calls task(i) for every i in [0, count), splitting the range into contiguous parts
+// for the worker threads
+template <typename Task>
+void parallelFor(size_t count, Task task) {
+    NullSink none;
+    unsigned threads = parallelism(2 * count);
+    runParallel(threads, none, [&](unsigned t, NullSink&) {
+        for (size_t i = count * t / threads; i < count * (t + 1) / threads; i++) {
+            task(i);
+        }
+    });
+}
+
+// Input generation. Values come from xoshiro256** streams seeded through splitmix64.
+// Arrays are filled in fixed-size chunks, each from its own stream derived from the
+// seed and the chunk number, so the chunks can be generated in parallel and the result
+// depends only on the seed, never on the number of threads.
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+class Xoshiro256 {
+private:
+    uint64_t s[4];
+    
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+    
+public:
+    using result_type = uint64_t;
+    
+    explicit Xoshiro256(uint64_t seed) {
+        for (uint64_t& word : s) {
+            word = splitmix64(seed);
+        }
+    }
+    
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+    
+    result_type operator()() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+    
+    // Uniform integer in [0, bound) by multiply-shift (Lemire); bias is below 2^-32
+    uint32_t below(uint32_t bound) {
+        return static_cast<uint32_t>(((*this)() >> 32) * bound >> 32);
+    }
+    
+    // Uniform double in [0, 1)
+    double unit() {
+        return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+enum class InputDistribution {
+    UNIFORM,
+    SORTED,
+    REVERSED,
+    FEW_UNIQUE,
+    NEARLY_SORTED,   // sorted, then about 1% of the elements swapped with a close neighbour
+    ORGAN_PIPE,      // ascending to the middle, then descending
+    QUICKSORT_KILLER // Musser's median-of-3 killer sequence
+};
+
+struct DistributionInfo {
+    InputDistribution distribution;
+    const char* key;  // command-line name
+    const char* name; // display name
+};
+
+const DistributionInfo DISTRIBUTIONS[] = {
+    {InputDistribution::UNIFORM, "uniform", "Uniform"},
+    {InputDistribution::SORTED, "sorted", "Sorted"},
+    {InputDistribution::REVERSED, "reversed", "Reversed"},
+    {InputDistribution::FEW_UNIQUE, "few-unique", "Few Unique"},
+    {InputDistribution::NEARLY_SORTED, "nearly-sorted", "Nearly Sorted"},
+    {InputDistribution::ORGAN_PIPE, "organ-pipe", "Organ Pipe"},
+    {InputDistribution::QUICKSORT_KILLER, "qsort-killer", "Quicksort Killer"}
+};
+
+inline const DistributionInfo& distributionInfo(InputDistribution distribution) {
+    for (const auto& info : DISTRIBUTIONS) {
+        if (info.distribution == distribution) {
+            return info;
+        }
+    }
+    return DISTRIBUTIONS[0];
+}
+
+inline const char* distributionKey(InputDistribution distribution) {
+    return distributionInfo(distribution).key;
+}
+
+// Rank of position i in Musser's median-of-3 killer of length 2k: the odd ranks and the
+// upper half alternate in the first half, the even ranks fill the second. The sequence
+// is only a permutation for even k, so it covers the longest prefix whose length is a
+// multiple of 4 and the up to 3 remaining, largest values follow in ascending order.
+inline size_t killerRank(size_t i, size_t n) {
+    size_t k = n / 4 * 2;
+    if (i >= 2 * k) {
+        return i;
+    }
+    if (i >= k) {
+        return 2 * (i - k) + 1;
+    }
+    return i % 2 == 0 ? i : k + i - 1;
+}
+
+// Fills out with n values in [10, maxValue] following `distribution`
+inline void generateArray(std::vector<int>& out, size_t n, int maxValue, InputDistribution distribution,
+                          uint64_t seed) {
+    const size_t CHUNK = 1 << 16;
+    out.resize(n);
+    if (n == 0) {
+        return;
+    }
+    
+    uint32_t span = static_cast<uint32_t>(std::max(1, maxValue - 9));
+    size_t chunks = (n + CHUNK - 1) / CHUNK;
+    
+    // The r-th smallest of n evenly spread values, jittered within its step so
+    // that sorted inputs still vary with the seed
+    auto ramp = [span](size_t r, size_t count, Xoshiro256& rng) {
+        double step = (r + rng.unit()) * span / count;
+        return 10 + static_cast<int>(std::min<double>(span - 1, step));
+    };
+    
+    auto fillChunk = [&](size_t chunk) {
+        uint64_t chunkSeed = seed ^ (chunk * 0xD1B54A32D192ED03ull);
+        Xoshiro256 rng(splitmix64(chunkSeed));
+        size_t begin = chunk * CHUNK;
+        size_t end = std::min(n, begin + CHUNK);
+        
+        for (size_t i = begin; i < end; i++) {
+            switch (distribution) {
+                case InputDistribution::UNIFORM:
+                    out[i] = 10 + static_cast<int>(rng.below(span));
+                    break;
+                case InputDistribution::SORTED:
+                case InputDistribution::NEARLY_SORTED:
+                    out[i] = ramp(i, n, rng);
+                    break;
+                case InputDistribution::REVERSED:
+                    out[i] = ramp(n - 1 - i, n, rng);
+                    break;
+                case InputDistribution::FEW_UNIQUE:
+                    out[i] = 10 + static_cast<int>(rng.below(8) * static_cast<int64_t>(maxValue - 10) / 7);
+                    break;
+                case InputDistribution::ORGAN_PIPE:
+                    out[i] = ramp(std::min(i, n - 1 - i), (n + 1) / 2, rng);
+                    break;
+                case InputDistribution::QUICKSORT_KILLER:
+                    out[i] = ramp(killerRank(i, n), n, rng);
+                    break;
+            }
+        }
+        
+        // Swaps stay inside the chunk so chunks remain independent
+        if (distribution == InputDistribution::NEARLY_SORTED && end - begin > 1) {
+            size_t length = end - begin;
+            for (size_t swaps = length / 200; swaps > 0; swaps--) {
+                size_t i = begin + rng.below(static_cast<uint32_t>(length));
+                size_t j = std::min(end - 1, i + 1 + rng.below(16));
+                std::swap(out[i], out[j]);
+            }
+        }
+    };
+    
+    parallelFor(chunks, fillChunk);
+}
+
+// Pathfinding grid: one byte per cell in a contiguous row-major array.
+// States: 0 = empty, 1 = obstacle, 2 = visited, 3 = path, 4 = frontier
+struct GridMap {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> cells;
+    int start = 0; // row-major cell index
+    int end = 0;
+    
+    size_t cellCount() const { return cells.size(); }
+    int index(int x, int y) const { return y * width + x; }
+    int xOf(uint32_t cell) const { return static_cast<int>(cell % width); }
+    int yOf(uint32_t cell) const { return static_cast<int>(cell / width); }
+    bool contains(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+    bool isObstacle(uint32_t cell) const { return cells[cell] == 1; }
+};
+
+// Open-list entry of the informed searches: ordered by f = g + h, then by h so that
+// ties expand the node closest to the goal first
+struct OpenEntry {
+    uint32_t f;
+    uint32_t h;
+    uint32_t cell;
+    
+    bool operator>(const OpenEntry& other) const {
+        return f != other.f ? f > other.f : h > other.h;
+    }
+};
+
+// 64 cells of a row as parallel bitsets, one cache line per word: free cells, the
+// cells reached this level and, per search side (start, end), seen cells and their
+// BFS level mod 3 as two bit planes
+struct alignas(64) BitWord {
+    uint64_t free;
+    uint64_t next;
+    uint64_t seen[2];
+    uint64_t level[2][2];
+};
+
+// Per-search working arrays, kept between runs so repeated searches do not reallocate
+struct SearchScratch {
+    std::vector<uint64_t> visited;   // one bit per cell
+    std::vector<uint32_t> parent;    // predecessor cell, valid once a cell is reached
+    std::vector<uint32_t> distance;  // Dijkstra's tentative distances
+    std::vector<uint32_t> frontier;  // BFS queue / DFS stack storage
+    std::vector<uint64_t> heap;      // Dijkstra's (distance, cell) heap storage
+    std::vector<OpenEntry> open;     // A* / JPS open list storage
+    std::vector<std::vector<uint32_t>> buckets; // bucket-queue Dijkstra's ring of buckets
+    
+    // Bit-parallel BFS: row-padded bitset words and each side's frontier as (word, bits)
+    size_t bitStride = 0;      // words per row, a power of two
+    unsigned bitStrideShift = 0;
+    std::vector<BitWord> bits;
+    std::vector<std::pair<uint32_t, uint64_t>> wave[2];
+    std::vector<std::pair<uint32_t, uint64_t>> nextWave;
+    std::vector<uint32_t> touched;
+    
+    // Parallel BFS: visited bits claimed atomically, and the second frontier buffer
+    std::unique_ptr<std::atomic<uint64_t>[]> claimed;
+    size_t claimedWords = 0;
+    std::vector<uint32_t> nextFrontier;
+    
+    void reset(size_t cellCount) {
+        visited.assign((cellCount + 63) / 64, 0);
+        if (parent.size() < cellCount) {
+            parent.resize(cellCount);
+        }
+        frontier.clear();
+        heap.clear();
+        open.clear();
+    }
+    
+    void resetDistances(size_t cellCount) {
+        distance.assign(cellCount, UINT32_MAX);
+    }
+    
+    bool isVisited(uint32_t cell) const {
+        return (visited[cell >> 6] >> (cell & 63)) & 1;
+    }
+    
+    // Marks the cell visited; returns false if it already was
+    bool markVisited(uint32_t cell) {
+        uint64_t bit = uint64_t(1) << (cell & 63);
+        uint64_t& word = visited[cell >> 6];
+        if (word & bit) {
+            return false;
+        }
+        word |= bit;
+        return true;
+    }
+    
+    void resetClaims(size_t cellCount) {
+        size_t words = (cellCount + 63) / 64;
+        if (words > claimedWords) {
+            claimed.reset(new std::atomic<uint64_t>[words]);
+            claimedWords = words;
+        }
+        for (size_t i = 0; i < words; i++) {
+            claimed[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    // Thread-safe markVisited(): exactly one caller wins each cell. The plain load
+    // skips the locked read-modify-write for cells that were claimed long ago, and a
+    // single claiming thread (`shared` false) never needs it.
+    bool claim(uint32_t cell, bool shared) {
+        uint64_t bit = uint64_t(1) << (cell & 63);
+        std::atomic<uint64_t>& word = claimed[cell >> 6];
+        uint64_t bits = word.load(std::memory_order_relaxed);
+        if (bits & bit) {
+            return false;
+        }
+        if (!shared) {
+            word.store(bits | bit, std::memory_order_relaxed);
+            return true;
+        }
+        return !(word.fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+};
+
+// Grid generation. Like arrays, grids are built from streams derived from the seed and a
+// fixed partition of the grid (rows, bands or maze regions), so every pattern can be
+// generated in parallel and still depends only on the seed.
+enum class GridPattern {
+    RANDOM,   // independent obstacles with the given density
+    DIVISION, // recursive-division maze
+    ELLER,    // Eller's-algorithm maze
+    CAVES,    // cellular-automaton caves
+    TERRAIN   // fractal value-noise terrain, the highest ground impassable
+};
+
+struct GridPatternInfo {
+    GridPattern pattern;
+    const char* key;  // command-line name
+    const char* name; // display name
+};
+
+const GridPatternInfo GRID_PATTERNS[] = {
+    {GridPattern::RANDOM, "random", "Random"},
+    {GridPattern::DIVISION, "division", "Recursive Division Maze"},
+    {GridPattern::ELLER, "eller", "Eller's Maze"},
+    {GridPattern::CAVES, "caves", "Caves"},
+    {GridPattern::TERRAIN, "terrain", "Terrain"}
+};
+
+inline const GridPatternInfo& gridPatternInfo(GridPattern pattern) {
+    for (const auto& info : GRID_PATTERNS) {
+        if (info.pattern == pattern) {
+            return info;
+        }
+    }
+    return GRID_PATTERNS[0];
+}
+
+// Stream for one part of a generated input, identified by up to four numbers
+inline Xoshiro256 partStream(uint64_t seed, uint64_t a, uint64_t b = 0, uint64_t c = 0, uint64_t d = 0) {
+    uint64_t state = seed;
+    for (uint64_t value : {a, b, c, d}) {
+        state = splitmix64(state) ^ value;
+    }
+    return Xoshiro256(splitmix64(state));
+}
+
+// Mazes place their cells at even coordinates; the cells between two maze cells are
+// passages and the cells at odd coordinates in both directions are always walls.
+// With `open` every passage starts open, otherwise every passage starts as a wall.
+inline void initMaze(GridMap& grid, bool open) {
+    int lastX = (grid.width - 1) & ~1;
+    int lastY = (grid.height - 1) & ~1;
+    parallelFor(grid.height, [&](size_t row) {
+        int y = static_cast<int>(row);
+        for (int x = 0; x < grid.width; x++) {
+            bool cell = x % 2 == 0 && y % 2 == 0;
+            bool passage = (x % 2) != (y % 2) && x <= lastX && y <= lastY;
+            grid.cells[grid.index(x, y)] = cell || (open && passage) ? 0 : 1;
+        }
+    });
+}
+
+// Recursive division: every region of maze cells is split by a wall with one gap,
+// alternating towards the shorter side. Regions are split breadth-first until there
+// are enough of them for the worker threads, then finished independently; each split
+// draws from a stream keyed by its region, so the result does not depend on the order.
+inline void divisionMaze(GridMap& grid, uint64_t seed) {
+    struct Region {
+        int x0, y0, x1, y1; // maze cells [x0, x1) x [y0, y1)
+    };
+    
+    initMaze(grid, true);
+    
+    // Splits a region in two, or returns false when it is a single corridor
+    auto split = [&grid, seed](const Region& r, Region& first, Region& second) {
+        int w = r.x1 - r.x0;
+        int h = r.y1 - r.y0;
+        if (w < 2 || h < 2) {
+            return false;
+        }
+        Xoshiro256 rng = partStream(seed, r.x0, r.y0, r.x1, r.y1);
+        bool horizontal = h > w || (h == w && rng.below(2));
+        if (horizontal) {
+            int k = r.y0 + 1 + static_cast<int>(rng.below(h - 1));
+            int gap = r.x0 + static_cast<int>(rng.below(w));
+            for (int i = r.x0; i < r.x1; i++) {
+                if (i != gap) {
+                    grid.cells[grid.index(2 * i, 2 * k - 1)] = 1;
+                }
+            }
+            first = Region{r.x0, r.y0, r.x1, k};
+            second = Region{r.x0, k, r.x1, r.y1};
+        } else {
+            int k = r.x0 + 1 + static_cast<int>(rng.below(w - 1));
+            int gap = r.y0 + static_cast<int>(rng.below(h));
+            for (int j = r.y0; j < r.y1; j++) {
+                if (j != gap) {
+                    grid.cells[grid.index(2 * k - 1, 2 * j)] = 1;
+                }
+            }
+            first = Region{r.x0, r.y0, k, r.y1};
+            second = Region{k, r.y0, r.x1, r.y1};
+        }
+        return true;
+    };
+    
+    std::deque<Region> pending = {Region{0, 0, (grid.width + 1) / 2, (grid.height + 1) / 2}};
+    std::vector<Region> work;
+    size_t wanted = 16 * static_cast<size_t>(parallelism(SIZE_MAX));
+    while (!pending.empty() && pending.size() + work.size() < wanted) {
+        Region first, second;
+        if (split(pending.front(), first, second)) {
+            pending.push_back(first);
+            pending.push_back(second);
+        } else {
+            work.push_back(pending.front());
+        }
+        pending.pop_front();
+    }
+    work.insert(work.end(), pending.begin(), pending.end());
+    
+    parallelFor(work.size(), [&](size_t item) {
+        std::vector<Region> stack = {work[item]};
+        while (!stack.empty()) {
+            Region region = stack.back();
+            stack.pop_back();
+            Region first, second;
+            if (split(region, first, second)) {
+                stack.push_back(first);
+                stack.push_back(second);
+            }
+        }
+    });
+}
+
+// Eller's algorithm builds a perfect maze one row at a time, keeping only the current
+// row's sets. Bands of BAND rows are generated independently, each a perfect maze of
+// its own, and neighbouring bands are joined through one opening, which keeps the
+// whole maze perfect.
+inline void ellerMaze(GridMap& grid, uint64_t seed) {
+    const int BAND = 256;
+    int mazeWidth = (grid.width + 1) / 2;
+    int mazeHeight = (grid.height + 1) / 2;
+    int bands = (mazeHeight + BAND - 1) / BAND;
+    
+    initMaze(grid, false);
+    
+    parallelFor(bands, [&](size_t band) {
+        int rowBegin = static_cast<int>(band) * BAND;
+        int rowEnd = std::min(mazeHeight, rowBegin + BAND);
+        Xoshiro256 rng = partStream(seed, band);
+        
+        // Set ids stay below 2 * mazeWidth: a row carries at most mazeWidth sets down
+        std::vector<uint32_t> set(mazeWidth);
+        std::vector<uint32_t> parent(2 * mazeWidth);
+        std::vector<int> lastCell(2 * mazeWidth);
+        std::vector<uint8_t> goesDown(2 * mazeWidth);
+        std::vector<uint8_t> down(mazeWidth);
+        std::vector<uint8_t> used(2 * mazeWidth);
+        auto find = [&parent](uint32_t id) {
+            while (parent[id] != id) {
+                parent[id] = parent[parent[id]];
+                id = parent[id];
+            }
+            return id;
+        };
+        
+        for (int i = 0; i < mazeWidth; i++) {
+            set[i] = i;
+        }
+        for (int row = rowBegin; row < rowEnd; row++) {
+            bool last = row == rowEnd - 1;
+            for (uint32_t id = 0; id < parent.size(); id++) {
+                parent[id] = id;
+            }
+            
+            // Join neighbours of different sets at random; the last row joins them all
+            for (int i = 0; i + 1 < mazeWidth; i++) {
+                uint32_t a = find(set[i]);
+                uint32_t b = find(set[i + 1]);
+                if (a != b && (last || rng.below(2))) {
+                    parent[b] = a;
+                    grid.cells[grid.index(2 * i + 1, 2 * row)] = 0;
+                }
+            }
+            if (last) {
+                break;
+            }
+            
+            // Every set continues down at least once
+            std::fill(goesDown.begin(), goesDown.end(), 0);
+            for (int i = 0; i < mazeWidth; i++) {
+                set[i] = find(set[i]);
+                down[i] = rng.below(2);
+                goesDown[set[i]] |= down[i];
+                lastCell[set[i]] = i;
+            }
+            for (int i = 0; i < mazeWidth; i++) {
+                if (!goesDown[set[i]] && lastCell[set[i]] == i) {
+                    down[i] = 1;
+                }
+            }
+            
+            // Cells below keep the set they were reached from, the others start new ones
+            std::fill(used.begin(), used.end(), 0);
+            for (int i = 0; i < mazeWidth; i++) {
+                if (down[i]) {
+                    grid.cells[grid.index(2 * i, 2 * row + 1)] = 0;
+                    used[set[i]] = 1;
+                }
+            }
+            uint32_t fresh = 0;
+            for (int i = 0; i < mazeWidth; i++) {
+                if (!down[i]) {
+                    while (used[fresh]) {
+                        fresh++;
+                    }
+                    set[i] = fresh++;
+                }
+            }
+        }
+        
+        if (rowEnd < mazeHeight) {
+            int opening = static_cast<int>(rng.below(mazeWidth));
+            grid.cells[grid.index(2 * opening, 2 * rowEnd - 1)] = 0;
+        }
+    });
+}
+
+// Cellular-automaton caves: 45% random walls, then a few rounds of the 4-5 rule (a cell
+// becomes a wall when at least five of the nine cells around it are walls, counting
+// outside the grid as wall). Rows of each round are computed in parallel, each from
+// the column sums of the three rows around it.
+inline void caveGrid(GridMap& grid, uint64_t seed) {
+    const int ROUNDS = 5;
+    int width = grid.width;
+    int height = grid.height;
+    parallelFor(height, [&](size_t row) {
+        Xoshiro256 rng = partStream(seed, row);
+        uint8_t* cells = &grid.cells[row * width];
+        for (int x = 0; x < width; x++) {
+            cells[x] = rng.below(100) < 45;
+        }
+    });
+    
+    std::vector<uint8_t> next(grid.cells.size());
+    for (int round = 0; round < ROUNDS; round++) {
+        parallelFor(height, [&](size_t row) {
+            const uint8_t* cells = &grid.cells[row * width];
+            const uint8_t* above = row > 0 ? cells - width : nullptr;
+            const uint8_t* below = row + 1 < static_cast<size_t>(height) ? cells + width : nullptr;
+            auto column = [&](int x) {
+                if (x < 0 || x >= width) {
+                    return 3;
+                }
+                return (above ? above[x] : 1) + cells[x] + (below ? below[x] : 1);
+            };
+            
+            uint8_t* out = &next[row * width];
+            int left = 3;
+            int middle = column(0);
+            for (int x = 0; x < width; x++) {
+                int right = column(x + 1);
+                out[x] = left + middle + right >= 5;
+                left = middle;
+                middle = right;
+            }
+        });
+        grid.cells.swap(next);
+    }
+}
+
+// Lattice value in [0, 1) of value-noise octave `octave` at lattice point (x, y)
+inline double latticeValue(uint64_t seed, int octave, int64_t x, int64_t y) {
+    uint64_t state = seed ^ (static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull) ^
+                     (static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4Full) ^ static_cast<uint64_t>(octave);
+    return (splitmix64(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Terrain: fractal value noise of four octaves, each at twice the frequency and half the
+// weight of the previous one. The obstaclePercent% highest cells become obstacles; the
+// noise is quantized into the cells first so the exact threshold can be read off a
+// histogram. Along a row the lattice values only change every `scale` cells, so each
+// octave fetches them once per lattice cell.
+inline void terrainGrid(GridMap& grid, int obstaclePercent, uint64_t seed) {
+    const int OCTAVES = 4;
+    int width = grid.width;
+    double baseScale = std::max(8, std::max(grid.width, grid.height) / 6);
+    std::vector<std::array<size_t, 256>> histograms(grid.height);
+    
+    parallelFor(grid.height, [&](size_t row) {
+        std::vector<double> heights(width, 0);
+        double scale = baseScale;
+        double weight = 0.5;
+        for (int octave = 0; octave < OCTAVES; octave++) {
+            double fy = row / scale;
+            int64_t iy = static_cast<int64_t>(std::floor(fy));
+            double ty = fy - iy;
+            ty = ty * ty * (3 - 2 * ty);
+            
+            int64_t cached = INT64_MIN;
+            double left = 0;
+            double right = 0;
+            for (int x = 0; x < width; x++) {
+                double fx = x / scale;
+                int64_t ix = static_cast<int64_t>(std::floor(fx));
+                if (ix != cached) {
+                    left = cached == ix - 1 ? right :
+                           latticeValue(seed, octave, ix, iy) +
+                           (latticeValue(seed, octave, ix, iy + 1) - latticeValue(seed, octave, ix, iy)) * ty;
+                    right = latticeValue(seed, octave, ix + 1, iy) +
+                            (latticeValue(seed, octave, ix + 1, iy + 1) - latticeValue(seed, octave, ix + 1, iy)) * ty;
+                    cached = ix;
+                }
+                double tx = fx - ix;
+                tx = tx * tx * (3 - 2 * tx);
+                heights[x] += weight * (left + (right - left) * tx);
+            }
+            weight /= 2;
+            scale /= 2;
+        }
+        
+        std::array<size_t, 256>& histogram = histograms[row];
+        histogram.fill(0);
+        uint8_t* cells = &grid.cells[row * width];
+        for (int x = 0; x < width; x++) {
+            uint8_t level = static_cast<uint8_t>(std::min(255.0, heights[x] / 0.9375 * 256));
+            cells[x] = level;
+            histogram[level]++;
+        }
+    });
+    
+    size_t wanted = grid.cells.size() * obstaclePercent / 100;
+    size_t above = 0;
+    int threshold = 256;
+    while (threshold > 0) {
+        size_t count = 0;
+        for (const auto& histogram : histograms) {
+            count += histogram[threshold - 1];
+        }
+        if (above + count > wanted) {
+            break;
+        }
+        above += count;
+        threshold--;
+    }
+    
+    parallelFor(grid.height, [&](size_t row) {
+        uint8_t* cells = &grid.cells[row * width];
+        for (int x = 0; x < width; x++) {
+            cells[x] = cells[x] >= threshold;
+        }
+    });
+}
+
+// Puts the start and end in the largest 4-connected region of free cells, on its cells
+// nearest the top-left and bottom-right corners (by x + y), so the search always has a
+// path to find. Regions are flood-filled a row span at a time with one visited bit per
+// cell. Returns false, leaving the endpoints alone, when no cell is free.
+inline bool placeInLargestRegion(GridMap& grid) {
+    std::vector<uint64_t> seen((grid.cellCount() + 63) / 64, 0);
+    auto open = [&](int x, int y) {
+        size_t cell = static_cast<size_t>(grid.index(x, y));
+        return !grid.cells[cell] && !(seen[cell >> 6] >> (cell & 63) & 1);
+    };
+    
+    // Stops once the cells not yet filled could not form a larger region
+    size_t unfilled = static_cast<size_t>(std::count(grid.cells.begin(), grid.cells.end(), 0));
+    size_t largest = 0;
+    std::vector<std::pair<int, int>> pending; // first cells of spans still to fill
+    for (int y = 0; y < grid.height && unfilled > largest; y++) {
+        for (int x = 0; x < grid.width && unfilled > largest; x++) {
+            if (!open(x, y)) {
+                continue;
+            }
+            
+            size_t size = 0;
+            int first = grid.index(x, y);
+            int last = first;
+            pending.emplace_back(x, y);
+            while (!pending.empty()) {
+                int spanY = pending.back().second;
+                int left = pending.back().first;
+                pending.pop_back();
+                if (!open(left, spanY)) {
+                    continue;
+                }
+                int right = left;
+                while (left > 0 && open(left - 1, spanY)) {
+                    left--;
+                }
+                while (right + 1 < grid.width && open(right + 1, spanY)) {
+                    right++;
+                }
+                for (int i = left; i <= right; i++) {
+                    size_t cell = static_cast<size_t>(grid.index(i, spanY));
+                    seen[cell >> 6] |= 1ull << (cell & 63);
+                }
+                size += right - left + 1;
+                if (left + spanY < grid.xOf(first) + grid.yOf(first)) {
+                    first = grid.index(left, spanY);
+                }
+                if (right + spanY > grid.xOf(last) + grid.yOf(last)) {
+                    last = grid.index(right, spanY);
+                }
+                
+                // One seed per run of open cells in the rows above and below
+                for (int nextY : {spanY - 1, spanY + 1}) {
+                    if (nextY < 0 || nextY >= grid.height) {
+                        continue;
+                    }
+                    bool previous = false;
+                    for (int i = left; i <= right; i++) {
+                        bool current = open(i, nextY);
+                        if (current && !previous) {
+                            pending.emplace_back(i, nextY);
+                        }
+                        previous = current;
+                    }
+                }
+            }
+            
+            unfilled -= size;
+            if (size > largest) {
+                largest = size;
+                grid.start = first;
+                grid.end = last;
+            }
+        }
+    }
+    return largest > 0;
+}
+
+// Fills a width x height grid following `pattern`. Mazes are searched from the first
+// to the last maze cell, the other patterns within their largest open region (see
+// placeInLargestRegion); a grid without free cells uses the opened corners.
+inline void generateGrid(GridMap& grid, int width, int height, GridPattern pattern, int obstaclePercent,
+                         uint64_t seed) {
+    grid.width = width;
+    grid.height = height;
+    grid.cells.assign(static_cast<size_t>(width) * height, 0);
+    grid.start = 0;
+    grid.end = grid.index(width - 1, height - 1);
+    
+    switch (pattern) {
+        case GridPattern::RANDOM:
+            parallelFor(height, [&](size_t row) {
+                Xoshiro256 rng = partStream(seed, row);
+                uint8_t* cells = &grid.cells[row * width];
+                for (int x = 0; x < width; x++) {
+                    cells[x] = rng.below(100) < static_cast<uint32_t>(obstaclePercent);
+                }
+            });
+            break;
+        case GridPattern::DIVISION:
+        case GridPattern::ELLER:
+            if (pattern == GridPattern::DIVISION) {
+                divisionMaze(grid, seed);
+            } else {
+                ellerMaze(grid, seed);
+            }
+            grid.end = grid.index((width - 1) & ~1, (height - 1) & ~1);
+            break;
+        case GridPattern::CAVES:
+            caveGrid(grid, seed);
+            break;
+        case GridPattern::TERRAIN:
+            terrainGrid(grid, obstaclePercent, seed);
+            break;
+    }
+    
+    if (pattern != GridPattern::DIVISION && pattern != GridPattern::ELLER) {
+        placeInLargestRegion(grid);
+    }
+    grid.cells[grid.start] = 0;
+    grid.cells[grid.end] = 0;
+}
+
+// Input files
+// Read-only memory mapping of a whole file. Pages are faulted in as they are first
+// touched, so opening a multi-gigabyte input costs no upfront read.
+class MappedFile {
+private:
+    const uint8_t* bytes;
+    size_t length;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+    
+public:
+    MappedFile() :
+        bytes(nullptr),
+        length(0)
+#if defined(_WIN32)
+        , file(INVALID_HANDLE_VALUE),
+        mapping(nullptr)
+#endif
+    {
+    }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    ~MappedFile() {
+        unmap();
+    }
+    
+    bool open(const std::string& path) {
+        unmap();
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER fileSize;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+            std::cerr << "Cannot open " << path << std::endl;
+            unmap();
+            return false;
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+        if (length == 0) {
+            return true;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            std::cerr << "Cannot map " << path << std::endl;
+            unmap();
+            return false;
+        }
+        bytes = static_cast<const uint8_t*>(view);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            std::cerr << "Cannot open " << path << std::endl;
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return false;
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length == 0) {
+            ::close(fd);
+            return true;
+        }
+        void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps the file open
+        if (view == MAP_FAILED) {
+            std::cerr << "Cannot map " << path << std::endl;
+            length = 0;
+            return false;
+        }
+        madvise(view, length, MADV_SEQUENTIAL);
+        bytes = static_cast<const uint8_t*>(view);
+#endif
+        return true;
+    }
+    
+    void unmap() {
+#if defined(_WIN32)
+        if (bytes) {
+            UnmapViewOfFile(bytes);
+        }
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes) {
+            munmap(const_cast<uint8_t*>(bytes), length);
+        }
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+    
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+inline bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Loads a raw native-endian array of int32 values, or of int64 values when the name ends
+// in .i64 (clamped to the int range the sorts work on)
+inline bool loadArrayFile(const std::string& path, std::vector<int>& out) {
+    static_assert(sizeof(int) == sizeof(int32_t), "arrays are loaded as 32-bit ints");
+    
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    
+    bool wide = endsWith(path, ".i64");
+    size_t width = wide ? sizeof(int64_t) : sizeof(int32_t);
+    if (file.size() == 0 || file.size() % width != 0) {
+        std::cerr << path << " is not a whole number of " << width * 8 << "-bit values" << std::endl;
+        return false;
+    }
+    
+    // Mappings are page aligned, so the values can be read in place
+    size_t n = file.size() / width;
+    if (wide) {
+        const int64_t* values = reinterpret_cast<const int64_t*>(file.data());
+        out.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            out[i] = static_cast<int>(std::min<int64_t>(INT_MAX, std::max<int64_t>(INT_MIN, values[i])));
+        }
+    } else {
+        const int32_t* values = reinterpret_cast<const int32_t*>(file.data());
+        out.assign(values, values + n);
+    }
+    return true;
+}
+
+// Minimal tokenizer over a mapped text header; '#' starts a comment (as in PGM)
+struct HeaderReader {
+    const char* pos;
+    const char* end;
+    
+    void skipSpace() {
+        while (pos < end && (std::isspace(static_cast<unsigned char>(*pos)) || *pos == '#')) {
+            if (*pos == '#') {
+                while (pos < end && *pos != '\n') {
+                    pos++;
+                }
+            } else {
+                pos++;
+            }
+        }
+    }
+    
+    std::string word() {
+        skipSpace();
+        const char* first = pos;
+        while (pos < end && !std::isspace(static_cast<unsigned char>(*pos))) {
+            pos++;
+        }
+        return std::string(first, pos);
+    }
+    
+    bool number(long& value) {
+        std::string text = word();
+        char* parsed = nullptr;
+        value = std::strtol(text.c_str(), &parsed, 10);
+        return !text.empty() && *parsed == '\0';
+    }
+};
+
+// Puts the start and end in the map's largest open region, as for generated grids
+inline bool placeEndpoints(GridMap& grid, const std::string& path) {
+    if (!placeInLargestRegion(grid)) {
+        std::cerr << path << " has no free cells" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Whether a width x height grid fits the trace's cell indices; each side is checked
+// first so the product cannot overflow
+inline bool validGridSize(long width, long height) {
+    const long limit = static_cast<long>(StepEvent::INDEX_MASK);
+    return width > 0 && height > 0 && width <= limit && height <= limit &&
+           static_cast<uint64_t>(width) * static_cast<uint64_t>(height) <= StepEvent::INDEX_MASK;
+}
+
+// MovingAI benchmark maps: a "type/height/width/map" header, then one character per
+// cell; '.', 'G' and 'S' are passable, everything else ('@', 'O', 'T', 'W') blocks
+inline bool parseMovingAiMap(HeaderReader& reader, GridMap& grid, const std::string& path) {
+    long width = 0;
+    long height = 0;
+    for (std::string key = reader.word(); key != "map"; key = reader.word()) {
+        if (key.empty()) {
+            std::cerr << path << ": missing \"map\" line" << std::endl;
+            return false;
+        }
+        long value = 0;
+        if (key == "height" && reader.number(value)) {
+            height = value;
+        } else if (key == "width" && reader.number(value)) {
+            width = value;
+        } else if (key == "type") {
+            reader.word();
+        }
+    }
+    if (!validGridSize(width, height)) {
+        std::cerr << path << ": unsupported map size " << width << "x" << height << std::endl;
+        return false;
+    }
+    
+    grid.width = static_cast<int>(width);
+    grid.height = static_cast<int>(height);
+    grid.cells.assign(static_cast<size_t>(width) * height, 1);
+    for (int y = 0; y < grid.height; y++) {
+        while (reader.pos < reader.end && (*reader.pos == '\n' || *reader.pos == '\r')) {
+            reader.pos++;
+        }
+        if (reader.end - reader.pos < width) {
+            std::cerr << path << ": map ends at row " << y << std::endl;
+            return false;
+        }
+        for (int x = 0; x < grid.width; x++) {
+            char c = reader.pos[x];
+            if (c == '\n' || c == '\r') {
+                std::cerr << path << ": row " << y << " has " << x << " cells instead of " << width << std::endl;
+                return false;
+            }
+            grid.cells[grid.index(x, y)] = c == '.' || c == 'G' || c == 'S' ? 0 : 1;
+        }
+        reader.pos += width;
+    }
+    return placeEndpoints(grid, path);
+}
+
+// Binary (P5) or plain (P2) greymaps: pixels darker than half of maxval are obstacles
+inline bool parsePgm(HeaderReader& reader, GridMap& grid, const std::string& path) {
+    bool binary = reader.word() == "P5";
+    long width = 0;
+    long height = 0;
+    long maxValue = 0;
+    if (!reader.number(width) || !reader.number(height) || !reader.number(maxValue) ||
+        !validGridSize(width, height) || maxValue <= 0 || maxValue > 65535) {
+        std::cerr << path << ": bad PGM header" << std::endl;
+        return false;
+    }
+    
+    grid.width = static_cast<int>(width);
+    grid.height = static_cast<int>(height);
+    grid.cells.resize(static_cast<size_t>(width) * height);
+    size_t sampleBytes = maxValue > 255 ? 2 : 1;
+    
+    if (binary) {
+        // Exactly one whitespace byte separates maxval from the raster
+        const uint8_t* raster = reinterpret_cast<const uint8_t*>(reader.pos + 1);
+        if (reader.end - reader.pos - 1 < static_cast<ptrdiff_t>(grid.cells.size() * sampleBytes)) {
+            std::cerr << path << ": truncated PGM raster" << std::endl;
+            return false;
+        }
+        for (size_t cell = 0; cell < grid.cells.size(); cell++) {
+            long value = sampleBytes == 2 ? raster[cell * 2] << 8 | raster[cell * 2 + 1] : raster[cell];
+            grid.cells[cell] = value * 2 < maxValue ? 1 : 0;
+        }
+    } else {
+        for (size_t cell = 0; cell < grid.cells.size(); cell++) {
+            long value = 0;
+            if (!reader.number(value)) {
+                std::cerr << path << ": truncated PGM raster" << std::endl;
+                return false;
+            }
+            grid.cells[cell] = value * 2 < maxValue ? 1 : 0;
+        }
+    }
+    return placeEndpoints(grid, path);
+}
+
+// Loads a MovingAI .map or a PGM image as a grid, recognised by the file's first bytes
+inline bool loadGridFile(const std::string& path, GridMap& grid) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    
+    const char* text = reinterpret_cast<const char*>(file.data());
+    HeaderReader reader{text, text + file.size()};
+    if (file.size() >= 2 && text[0] == 'P' && (text[1] == '5' || text[1] == '2')) {
+        return parsePgm(reader, grid, path);
+    }
+    if (file.size() >= 4 && std::string(text, 4) == "type") {
+        return parseMovingAiMap(reader, grid, path);
+    }
+    std::cerr << path << " is neither a MovingAI map nor a PGM image" << std::endl;
+    return false;
+}
+
+// Trace files
+// A recorded run: a header, then a stream of delta/varint-encoded steps interleaved
+// with periodic keyframes holding the full array or grid state, and finally an index
+// of the keyframes. Seeking binary-searches the index and replays from the keyframe
+// before the target, so any step of a multi-billion step trace is a short decode away.
+//
+//   header   "AVTRACE1", u32 version, algorithm, pathfinding, width, height,
+//            i32 start, end, u64 state count (width = element count for arrays)
+//   step     u8 type | 0x10 if the operand delta is zero, varint zigzag index delta,
+//            [varint zigzag operand delta]; operands are relative to the index for
+//            compares and swaps and to the previous value for writes
+//   keyframe u8 0xF0, u64 step, varint counters, varint thread, state as i32 (arrays)
+//            or u8 (grids) per element; the deltas restart from zero after it
+//   footer   u8 0xF1, (u64 step, u64 offset) per keyframe, u64 index offset,
+//            u64 keyframe count, u64 step count, "AVTRIDX1"
+// Fixed-width fields are stored in native (little-endian) byte order.
+struct TraceHeader {
+    AlgorithmType algorithm = AlgorithmType::BUBBLE_SORT;
+    bool pathfinding = false;
+    uint32_t width = 0;
+    uint32_t height = 1;
+    int32_t start = 0;
+    int32_t end = 0;
+    uint64_t stateCount = 0;
+};
+
+const char TRACE_MAGIC[8] = {'A', 'V', 'T', 'R', 'A', 'C', 'E', '1'};
+const char TRACE_INDEX_MAGIC[8] = {'A', 'V', 'T', 'R', 'I', 'D', 'X', '1'};
+const uint32_t TRACE_VERSION = 1;
+const uint8_t TRACE_OPERAND_ZERO = 0x10;
+const uint8_t TRACE_KEYFRAME = 0xF0;
+const uint8_t TRACE_END = 0xF1;
+const size_t TRACE_HEADER_BYTES = 44;
+const size_t TRACE_TRAILER_BYTES = 32;
+
+// The state a trace keyframe stores: the array values of a sort, or the cell states
+// the visualizer draws for a search (0 free, 1 obstacle, 2 visited, 3 path, 4 frontier),
+// kept at one byte per cell as in the file
+struct TraceState {
+    std::vector<int32_t> values;
+    std::vector<uint8_t> cells;
+};
+
+// Applies a step to a trace state
+inline void applyTraceStep(TraceState& state, bool pathfinding, const StepEvent& step) {
+    size_t i = step.index();
+    if (pathfinding) {
+        if (i >= state.cells.size()) {
+            return;
+        }
+        switch (step.type()) {
+            case StepType::VISIT: state.cells[i] = 2; break;
+            case StepType::PATH: state.cells[i] = 3; break;
+            case StepType::PUSH: state.cells[i] = 4; break;
+            default: break;
+        }
+        return;
+    }
+    
+    if (i >= state.values.size()) {
+        return;
+    }
+    switch (step.type()) {
+        case StepType::SWAP:
+            if (step.operand < state.values.size()) {
+                std::swap(state.values[i], state.values[step.operand]);
+            }
+            break;
+        case StepType::WRITE:
+            state.values[i] = step.value();
+            break;
+        default:
+            break;
+    }
+}
+
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// The value a step's operand is delta-encoded against
+inline int64_t traceOperandBase(StepType type, uint32_t index, uint32_t lastWrite) {
+    switch (type) {
+        case StepType::COMPARE:
+        case StepType::SWAP:
+            return index;
+        case StepType::WRITE:
+            return static_cast<int32_t>(lastWrite);
+        default:
+            return 0;
+    }
+}
+
+inline int64_t traceOperand(StepType type, uint32_t operand) {
+    return type == StepType::WRITE ? static_cast<int32_t>(operand) : static_cast<int64_t>(operand);
+}
+
+// Records steps straight to a trace file through a large write buffer. A keyframe is
+// written once the steps since the last one take four times the state's size (and at
+// least 1 MiB), so keyframes add at most a quarter to the file and a seek decodes at
+// most four state sizes' worth of steps.
+class TraceWriter : public StepSink<TraceWriter> {
+private:
+    static const size_t BUFFER_BYTES = 1 << 20;
+    
+    std::FILE* file;
+    std::vector<uint8_t> buffer;
+    uint64_t offset; // file position of buffer[0]
+    bool failed;
+    
+    TraceHeader header;
+    TraceState state;
+    size_t currentThread;
+    uint64_t steps;
+    uint64_t keyframeInterval; // bytes of steps between keyframes
+    uint64_t lastKeyframe;     // file offset just past the last keyframe
+    std::vector<std::pair<uint64_t, uint64_t>> keyframes;
+    uint32_t lastIndex;
+    uint32_t lastWrite;
+    
+    void flushBuffer() {
+        if (file && !buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            failed = true;
+        }
+        offset += buffer.size();
+        buffer.clear();
+    }
+    
+    void putBytes(const void* data, size_t count) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (count > 0) {
+            size_t room = std::min(count, BUFFER_BYTES - buffer.size());
+            buffer.insert(buffer.end(), bytes, bytes + room);
+            bytes += room;
+            count -= room;
+            if (buffer.size() == BUFFER_BYTES) {
+                flushBuffer();
+            }
+        }
+    }
+    
+    template <typename T>
+    void putFixed(T value) {
+        putBytes(&value, sizeof(value));
+    }
+    
+    void putVarint(uint64_t value) {
+        uint8_t bytes[10];
+        size_t count = 0;
+        do {
+            bytes[count++] = static_cast<uint8_t>((value & 0x7F) | (value >= 0x80 ? 0x80 : 0));
+            value >>= 7;
+        } while (value);
+        putBytes(bytes, count);
+    }
+    
+    void writeKeyframe() {
+        keyframes.emplace_back(steps, offset + buffer.size());
+        lastIndex = 0;
+        lastWrite = 0;
+        
+        putFixed(TRACE_KEYFRAME);
+        putFixed(steps);
+        const uint64_t values[] = {counters.comparisons, counters.swaps, counters.reads, counters.writes,
+                                   counters.pushes, counters.pops, counters.visits, counters.pathCells};
+        for (uint64_t value : values) {
+            putVarint(value);
+        }
+        putVarint(currentThread);
+        
+        if (header.pathfinding) {
+            putBytes(state.cells.data(), state.cells.size());
+        } else {
+            putBytes(state.values.data(), state.values.size() * sizeof(int32_t));
+        }
+        lastKeyframe = offset + buffer.size();
+    }
+    
+public:
+    OpCounters counters;
+    
+    TraceWriter() :
+        file(nullptr),
+        offset(0),
+        failed(false),
+        currentThread(0),
+        steps(0),
+        keyframeInterval(0),
+        lastKeyframe(0),
+        lastIndex(0),
+        lastWrite(0)
+    {
+    }
+    
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    
+    ~TraceWriter() {
+        finish();
+    }
+    
+    // Starts a trace of a run on initialState (array values, or grid cells as 0/1)
+    bool open(const std::string& path, const TraceHeader& info, TraceState initialState) {
+        finish();
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "Cannot create " << path << std::endl;
+            return false;
+        }
+        
+        header = info;
+        header.stateCount = header.pathfinding ? initialState.cells.size() : initialState.values.size();
+        state = std::move(initialState);
+        buffer.reserve(BUFFER_BYTES);
+        offset = 0;
+        failed = false;
+        counters = OpCounters();
+        currentThread = 0;
+        steps = 0;
+        keyframeInterval = std::max<uint64_t>(uint64_t(1) << 20,
+                                              4 * header.stateCount * (header.pathfinding ? 1 : sizeof(int32_t)));
+        keyframes.clear();
+        
+        putBytes(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        putFixed(TRACE_VERSION);
+        putFixed(static_cast<uint32_t>(header.algorithm));
+        putFixed(static_cast<uint32_t>(header.pathfinding));
+        putFixed(header.width);
+        putFixed(header.height);
+        putFixed(header.start);
+        putFixed(header.end);
+        putFixed(header.stateCount);
+        writeKeyframe();
+        return true;
+    }
+    
+    void emit(const StepEvent& step) {
+        if (offset + buffer.size() - lastKeyframe >= keyframeInterval) {
+            writeKeyframe();
+        }
+        
+        StepType type = step.type();
+        uint32_t index = static_cast<uint32_t>(step.index());
+        int64_t operandDelta = traceOperand(type, step.operand) - traceOperandBase(type, index, lastWrite);
+        
+        putFixed(static_cast<uint8_t>(static_cast<uint8_t>(type) | (operandDelta == 0 ? TRACE_OPERAND_ZERO : 0)));
+        putVarint(zigzag(static_cast<int64_t>(index) - lastIndex));
+        if (operandDelta != 0) {
+            putVarint(zigzag(operandDelta));
+        }
+        
+        lastIndex = index;
+        if (type == StepType::WRITE) {
+            lastWrite = step.operand;
+        }
+        if (type == StepType::THREAD) {
+            currentThread = index;
+        }
+        applyTraceStep(state, header.pathfinding, step);
+        counters.count(step);
+        steps++;
+    }
+    
+    bool active() const { return !failed; }
+    
+    bool isOpen() const { return file != nullptr; }
+    uint64_t stepCount() const { return steps; }
+    
+    // Writes the keyframe index and closes the file; returns false if any write failed
+    bool finish() {
+        if (!file) {
+            return !failed;
+        }
+        
+        putFixed(TRACE_END);
+        uint64_t indexOffset = offset + buffer.size();
+        for (const auto& keyframe : keyframes) {
+            putFixed(keyframe.first);
+            putFixed(keyframe.second);
+        }
+        putFixed(indexOffset);
+        putFixed(static_cast<uint64_t>(keyframes.size()));
+        putFixed(steps);
+        putBytes(TRACE_INDEX_MAGIC, sizeof(TRACE_INDEX_MAGIC));
+        flushBuffer();
+        
+        if (std::fclose(file) != 0) {
+            failed = true;
+        }
+        file = nullptr;
+        if (failed) {
+            std::cerr << "Writing the trace failed" << std::endl;
+        }
+        return !failed;
+    }
+};
+
+// Starts a trace of a sort of `a`
+inline bool openTrace(TraceWriter& writer, const std::string& path, AlgorithmType algorithm,
+                      const std::vector<int>& a) {
+    TraceHeader header;
+    header.algorithm = algorithm;
+    header.width = static_cast<uint32_t>(a.size());
+    TraceState state;
+    state.values.assign(a.begin(), a.end());
+    return writer.open(path, header, std::move(state));
+}
+
+// Starts a trace of a search on `grid`
+inline bool openTrace(TraceWriter& writer, const std::string& path, AlgorithmType algorithm, const GridMap& grid) {
+    TraceHeader header;
+    header.algorithm = algorithm;
+    header.pathfinding = true;
+    header.width = static_cast<uint32_t>(grid.width);
+    header.height = static_cast<uint32_t>(grid.height);
+    header.start = grid.start;
+    header.end = grid.end;
+    TraceState state;
+    state.cells = grid.cells;
+    return writer.open(path, header, std::move(state));
+}
+
+// Writes every step to a trace on the algorithm's own thread and passes it on to `out`
+// until `detached` is set, so a recording is not limited by how many steps `out` keeps
+template <typename Sink>
+class RecordingSink : public StepSink<RecordingSink<Sink>> {
+private:
+    Sink& out;
+    TraceWriter& writer;
+    const std::atomic<bool>& detached;
+    
+public:
+    RecordingSink(Sink& sink, TraceWriter& traceWriter, const std::atomic<bool>& detachFlag) :
+        out(sink), writer(traceWriter), detached(detachFlag) {}
+    
+    void emit(const StepEvent& step) {
+        writer.emit(step);
+        if (!detached.load(std::memory_order_relaxed)) {
+            out.emit(step);
+        }
+    }
+    
+    bool active() const { return out.active(); }
+};
+
+// Runs run(sink) on the worker's sink, through a RecordingSink when writer is set
+template <typename Run>
+void runRecorded(QueueSink& out, TraceWriter* writer, const std::atomic<bool>& detached, Run run) {
+    if (writer) {
+        RecordingSink<QueueSink> sink(out, *writer, detached);
+        run(sink);
+    } else {
+        run(out);
+    }
+}
+
+// Reads a trace through a memory mapping; only the keyframe index is copied out
+class TraceReader {
+private:
+    MappedFile file;
+    TraceHeader header;
+    std::vector<std::pair<uint64_t, uint64_t>> keyframes; // (step, offset)
+    uint64_t totalSteps;
+    
+    // Decoder position
+    size_t pos;
+    size_t limit; // start of the footer
+    uint64_t step;
+    uint32_t lastIndex;
+    uint32_t lastWrite;
+    
+    template <typename T>
+    bool getFixed(size_t& at, T& value) const {
+        if (at + sizeof(T) > file.size()) {
+            return false;
+        }
+        std::memcpy(&value, file.data() + at, sizeof(T));
+        at += sizeof(T);
+        return true;
+    }
+    
+    bool getVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; pos < limit && shift < 64; shift += 7) {
+            uint8_t byte = file.data()[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    size_t stateBytes() const {
+        return static_cast<size_t>(header.stateCount) * (header.pathfinding ? 1 : sizeof(int32_t));
+    }
+    
+    // Reads the keyframe at pos into the given outputs (any of which may be null)
+    bool readKeyframe(TraceState* state, OpCounters* counters, size_t* thread) {
+        uint64_t values[9];
+        pos += 1 + sizeof(uint64_t);
+        for (uint64_t& value : values) {
+            if (!getVarint(value)) {
+                return false;
+            }
+        }
+        if (pos + stateBytes() > limit) {
+            return false;
+        }
+        
+        if (counters) {
+            counters->comparisons = values[0];
+            counters->swaps = values[1];
+            counters->reads = values[2];
+            counters->writes = values[3];
+            counters->pushes = values[4];
+            counters->pops = values[5];
+            counters->visits = values[6];
+            counters->pathCells = values[7];
+        }
+        if (thread) {
+            *thread = static_cast<size_t>(values[8]);
+        }
+        if (state) {
+            const uint8_t* bytes = file.data() + pos;
+            if (header.pathfinding) {
+                state->cells.assign(bytes, bytes + header.stateCount);
+            } else {
+                state->values.resize(static_cast<size_t>(header.stateCount));
+                std::memcpy(state->values.data(), bytes, state->values.size() * sizeof(int32_t));
+            }
+        }
+        pos += stateBytes();
+        lastIndex = 0;
+        lastWrite = 0;
+        return true;
+    }
+    
+    // Decodes the next step, skipping keyframes; false at the end of the trace
+    bool next(StepEvent& event) {
+        while (step < totalSteps && pos < limit) {
+            uint8_t tag = file.data()[pos];
+            if (tag == TRACE_KEYFRAME) {
+                if (!readKeyframe(nullptr, nullptr, nullptr)) {
+                    break;
+                }
+                continue;
+            }
+            
+            pos++;
+            StepType type = static_cast<StepType>(tag & 0x0F);
+            uint64_t indexDelta = 0;
+            uint64_t operandDelta = 0;
+            if ((tag & ~TRACE_OPERAND_ZERO) > static_cast<uint8_t>(StepType::THREAD) || !getVarint(indexDelta) ||
+                (!(tag & TRACE_OPERAND_ZERO) && !getVarint(operandDelta))) {
+                break;
+            }
+            
+            uint32_t index = static_cast<uint32_t>(lastIndex + unzigzag(indexDelta));
+            int64_t operand = traceOperandBase(type, index, lastWrite) + unzigzag(operandDelta);
+            event = StepEvent::make(type, index & StepEvent::INDEX_MASK, static_cast<uint32_t>(operand));
+            lastIndex = index;
+            if (type == StepType::WRITE) {
+                lastWrite = event.operand;
+            }
+            step++;
+            return true;
+        }
+        
+        step = totalSteps; // truncated or corrupt: stop here
+        return false;
+    }
+    
+public:
+    TraceReader() : totalSteps(0), pos(0), limit(0), step(0), lastIndex(0), lastWrite(0) {}
+    
+    bool open(const std::string& path) {
+        if (!file.open(path)) {
+            return false;
+        }
+        
+        size_t at = 0;
+        char magic[8];
+        uint32_t version = 0, algorithm = 0, pathfinding = 0;
+        bool valid = file.size() >= TRACE_HEADER_BYTES + TRACE_TRAILER_BYTES &&
+                     std::memcmp(file.data(), TRACE_MAGIC, sizeof(magic)) == 0;
+        at = sizeof(magic);
+        valid = valid && getFixed(at, version) && version == TRACE_VERSION && getFixed(at, algorithm) &&
+                getFixed(at, pathfinding) && getFixed(at, header.width) && getFixed(at, header.height) &&
+                getFixed(at, header.start) && getFixed(at, header.end) && getFixed(at, header.stateCount);
+        header.algorithm = static_cast<AlgorithmType>(algorithm);
+        header.pathfinding = pathfinding != 0;
+        
+        uint64_t indexOffset = 0, keyframeCount = 0;
+        at = file.size() - TRACE_TRAILER_BYTES;
+        valid = valid && getFixed(at, indexOffset) && getFixed(at, keyframeCount) && getFixed(at, totalSteps) &&
+                std::memcmp(file.data() + at, TRACE_INDEX_MAGIC, sizeof(magic)) == 0 &&
+                indexOffset + keyframeCount * 16 == file.size() - TRACE_TRAILER_BYTES && keyframeCount > 0;
+        if (!valid) {
+            std::cerr << path << " is not a readable trace" << std::endl;
+            file.unmap();
+            return false;
+        }
+        
+        keyframes.resize(static_cast<size_t>(keyframeCount));
+        at = static_cast<size_t>(indexOffset);
+        for (auto& keyframe : keyframes) {
+            getFixed(at, keyframe.first);
+            getFixed(at, keyframe.second);
+        }
+        limit = static_cast<size_t>(indexOffset);
+        pos = static_cast<size_t>(keyframes[0].second);
+        step = 0;
+        return true;
+    }
+    
+    const TraceHeader& info() const { return header; }
+    uint64_t steps() const { return totalSteps; }
+    uint64_t position() const { return step; }
+    bool atEnd() const { return step >= totalSteps; }
+    
+    // Positions the reader at step `target` and fills in the state, counters and worker
+    // thread in effect there: O(log keyframes) to find the keyframe, then a short replay
+    bool seek(uint64_t target, TraceState& state, OpCounters& counters, size_t& thread) {
+        target = std::min(target, totalSteps);
+        auto keyframe = std::upper_bound(keyframes.begin(), keyframes.end(), std::make_pair(target, UINT64_MAX)) - 1;
+        pos = static_cast<size_t>(keyframe->second);
+        step = keyframe->first;
+        if (pos >= limit || file.data()[pos] != TRACE_KEYFRAME || !readKeyframe(&state, &counters, &thread)) {
+            step = totalSteps;
+            return false;
+        }
+        
+        StepEvent event;
+        while (step < target && next(event)) {
+            applyTraceStep(state, header.pathfinding, event);
+            counters.count(event);
+            if (event.type() == StepType::THREAD) {
+                thread = event.index();
+            }
+        }
+        return step == target;
+    }
+    
+    // Decodes up to `count` steps from the current position onto out
+    size_t read(std::vector<StepEvent>& out, size_t count) {
+        size_t decoded = 0;
+        StepEvent event;
+        while (decoded < count && next(event)) {
+            out.push_back(event);
+            decoded++;
+        }
+        return decoded;
+    }
+};
+
+// Sorting Algorithms
+template <typename Sink>
+void bubbleSort(std::vector<int>& a, Sink& out) {
+    for (size_t i = 0; i + 1 < a.size() && out.active(); i++) {
+        for (size_t j = 0; j < a.size() - i - 1 && out.active(); j++) {
+            out.compare(j, j + 1);
+            if (a[j] > a[j + 1]) {
+                std::swap(a[j], a[j + 1]);
+                out.swap(j, j + 1);
+            }
+        }
+    }
+}
+
+// Sorts a[lo, hi)
+template <typename Sink>
+void insertionSort(std::vector<int>& a, size_t lo, size_t hi, Sink& out) {
+    for (size_t i = lo + 1; i < hi && out.active(); i++) {
+        int key = a[i];
+        out.read(i);
+        size_t j = i;
+        
+        // j is the hole the key will drop into
+        while (j > lo) {
+            out.compare(j - 1, j);
+            if (a[j - 1] <= key) {
+                break;
+            }
+            a[j] = a[j - 1];
+            out.write(j, a[j]);
+            j--;
+        }
+        
+        if (j != i) {
+            a[j] = key;
+            out.write(j, key);
+        }
+    }
+}
+
+template <typename Sink>
+void insertionSort(std::vector<int>& a, Sink& out) {
+    insertionSort(a, 0, a.size(), out);
+}
+
+template <typename Sink>
+void selectionSort(std::vector<int>& a, Sink& out) {
+    for (size_t i = 0; i + 1 < a.size() && out.active(); i++) {
+        size_t min_idx = i;
+        
+        for (size_t j = i + 1; j < a.size(); j++) {
+            out.compare(j, min_idx);
+            if (a[j] < a[min_idx]) {
+                min_idx = j;
+            }
+        }
+        
+        if (min_idx != i) {
+            std::swap(a[i], a[min_idx]);
+            out.swap(i, min_idx);
+        }
+    }
+}
+
+// Recurses into the smaller side and loops on the larger one, so the stack stays
+// O(log n) deep even when the last-element pivot splits unevenly
+template <typename Sink>
+void quickSort(std::vector<int>& a, int low, int high, Sink& out) {
+    while (low < high && out.active()) {
+        // Partition the array
+        int pivot = a[high];
+        out.read(high);
+        int i = low - 1;
+        
+        for (int j = low; j <= high - 1; j++) {
+            out.compare(j, high);
+            if (a[j] < pivot) {
+                i++;
+                std::swap(a[i], a[j]);
+                out.swap(i, j);
+            }
+        }
+        
+        std::swap(a[i + 1], a[high]);
+        out.swap(i + 1, high);
+        
+        int partition = i + 1;
+        
+        // Sort the smaller subarray recursively and continue with the larger one
+        if (partition - low < high - partition) {
+            quickSort(a, low, partition - 1, out);
+            low = partition + 1;
+        } else {
+            quickSort(a, partition + 1, high, out);
+            high = partition - 1;
+        }
+    }
+}
+
+// Index of the median of a[i], a[j] and a[k]
+template <typename Sink>
+size_t medianOfThree(const std::vector<int>& a, size_t i, size_t j, size_t k, Sink& out) {
+    out.compare(i, j);
+    out.compare(j, k);
+    if (a[i] < a[j]) {
+        if (a[j] < a[k]) {
+            return j;
+        }
+        out.compare(i, k);
+        return a[i] < a[k] ? k : i;
+    }
+    if (a[k] < a[j]) {
+        return j;
+    }
+    out.compare(i, k);
+    return a[k] < a[i] ? k : i;
+}
+
+// Median of three for short ranges, Tukey's ninther (median of three medians) for long ones
+template <typename Sink>
+size_t choosePivot(const std::vector<int>& a, size_t lo, size_t hi, Sink& out) {
+    size_t n = hi - lo + 1;
+    size_t mid = lo + n / 2;
+    if (n < 128) {
+        return medianOfThree(a, lo, mid, hi, out);
+    }
+    
+    size_t step = n / 8;
+    size_t first = medianOfThree(a, lo, lo + step, lo + 2 * step, out);
+    size_t middle = medianOfThree(a, mid - step, mid, mid + step, out);
+    size_t last = medianOfThree(a, hi - 2 * step, hi - step, hi, out);
+    return medianOfThree(a, first, middle, last, out);
+}
+
+// Hoare-style partition of a[lo, hi] around the chosen pivot. Both scans stop on keys
+// equal to the pivot, so runs of duplicates are split evenly. Returns the pivot's index.
+template <typename Sink>
+size_t hoarePartition(std::vector<int>& a, size_t lo, size_t hi, Sink& out) {
+    size_t p = choosePivot(a, lo, hi, out);
+    std::swap(a[lo], a[p]);
+    out.swap(lo, p);
+    
+    int pivot = a[lo];
+    size_t i = lo;
+    size_t j = hi + 1;
+    
+    while (true) {
+        do {
+            i++;
+            out.compare(i, lo);
+        } while (i < hi && a[i] < pivot);
+        
+        do {
+            j--;
+            out.compare(lo, j);
+        } while (j > lo && pivot < a[j]);
+        
+        if (i >= j) {
+            break;
+        }
+        std::swap(a[i], a[j]);
+        out.swap(i, j);
+    }
+    
+    std::swap(a[lo], a[j]);
+    out.swap(lo, j);
+    return j;
+}
+
+// Sequential quicksort of a[lo, hi]: recurses into the smaller side and loops on the
+// larger one, finishing ranges shorter than cutoff with insertion sort
+template <typename Sink>
+void quickSortRange(std::vector<int>& a, size_t lo, size_t hi, size_t cutoff, Sink& out) {
+    while (hi > lo && out.active()) {
+        if (hi - lo < cutoff) {
+            insertionSort(a, lo, hi + 1, out);
+            return;
+        }
+        
+        size_t p = hoarePartition(a, lo, hi, out);
+        if (p - lo < hi - p) {
+            if (p > lo) {
+                quickSortRange(a, lo, p - 1, cutoff, out);
+            }
+            lo = p + 1;
+        } else {
+            quickSortRange(a, p + 1, hi, cutoff, out);
+            if (p == lo) {
+                return;
+            }
+            hi = p - 1;
+        }
+    }
+}
+
+// Quicksort on a pool of workers, each with its own deque of pending ranges. A worker
+// partitions, pushes the larger side for others to steal and keeps the smaller side;
+// idle workers steal the oldest (largest) range from the others. Small ranges finish
+// with insertion sort. Every range is its own trace segment so stolen work replays after
+// the partition that produced it.
+template <typename Sink>
+void parallelQuickSort(std::vector<int>& a, Sink& out) {
+    const size_t INSERTION_CUTOFF = 16;
+    const size_t SPAWN_CUTOFF = 2048;
+    
+    struct RangeDeque {
+        std::mutex lock;
+        std::deque<std::pair<size_t, size_t>> ranges; // inclusive [lo, hi]
+    };
+    
+    if (a.size() < 2) {
+        return;
+    }
+    
+    unsigned threads = parallelism(a.size() / SPAWN_CUTOFF);
+    std::vector<RangeDeque> deques(threads);
+    std::atomic<size_t> pending(1); // ranges pushed but not yet finished
+    std::atomic<uint64_t> tickets(0);
+    deques[0].ranges.emplace_back(0, a.size() - 1);
+    
+    runParallel(threads, out, [&](unsigned t, auto& local) {
+        auto take = [&](std::pair<size_t, size_t>& range) {
+            for (unsigned k = 0; k < threads; k++) {
+                unsigned victim = (t + k) % threads;
+                std::lock_guard<std::mutex> guard(deques[victim].lock);
+                auto& ranges = deques[victim].ranges;
+                if (!ranges.empty()) {
+                    // Own work from the back (depth first), stolen work from the front
+                    if (victim == t) {
+                        range = ranges.back();
+                        ranges.pop_back();
+                    } else {
+                        range = ranges.front();
+                        ranges.pop_front();
+                    }
+                    return true;
+                }
+            }
+            return false;
+        };
+        
+        std::pair<size_t, size_t> range;
+        while (pending.load(std::memory_order_acquire) > 0 && local.active()) {
+            if (!take(range)) {
+                std::this_thread::yield();
+                continue;
+            }
+            
+            size_t lo = range.first;
+            size_t hi = range.second;
+            while (local.active()) {
+                beginSegment(local, tickets.fetch_add(1));
+                if (hi - lo < INSERTION_CUTOFF) {
+                    insertionSort(a, lo, hi + 1, local);
+                    break;
+                }
+                
+                size_t p = hoarePartition(a, lo, hi, local);
+                size_t leftSize = p - lo;
+                size_t rightSize = hi - p;
+                bool leftSmaller = leftSize < rightSize;
+                
+                // Hand the larger side to the pool if it is worth stealing
+                size_t bigLo = leftSmaller ? p + 1 : lo;
+                size_t bigHi = leftSmaller ? hi : p - 1;
+                size_t bigSize = std::max(leftSize, rightSize);
+                if (bigSize >= SPAWN_CUTOFF) {
+                    pending.fetch_add(1, std::memory_order_relaxed);
+                    std::lock_guard<std::mutex> guard(deques[t].lock);
+                    deques[t].ranges.emplace_back(bigLo, bigHi);
+                } else if (bigSize > 1) {
+                    beginSegment(local, tickets.fetch_add(1));
+                    if (bigSize <= INSERTION_CUTOFF) {
+                        insertionSort(a, bigLo, bigHi + 1, local);
+                    } else {
+                        quickSortRange(a, bigLo, bigHi, INSERTION_CUTOFF, local);
+                    }
+                }
+                
+                size_t smallSize = std::min(leftSize, rightSize);
+                if (smallSize < 2) {
+                    break;
+                }
+                lo = leftSmaller ? lo : p + 1;
+                hi = leftSmaller ? p - 1 : hi;
+            }
+            pending.fetch_sub(1, std::memory_order_release);
+        }
+    });
+}
+
+// Merges a[left, mid] with a[mid + 1, right]. Only the left run is copied out to the
+// preallocated buffer; the right run is consumed in place.
+template <typename Sink>
+void merge(std::vector<int>& a, std::vector<int>& buffer, int left, int mid, int right, Sink& out) {
+    int n1 = mid - left + 1;
+    
+    for (int i = 0; i < n1; i++) {
+        buffer[i] = a[left + i];
+        out.read(left + i);
+    }
+    
+    int i = 0, j = mid + 1, k = left;
+    
+    while (i < n1 && j <= right) {
+        out.compare(left + i, j);
+        if (buffer[i] <= a[j]) {
+            a[k] = buffer[i];
+            i++;
+        } else {
+            a[k] = a[j];
+            j++;
+        }
+        out.write(k, a[k]);
+        k++;
+    }
+    
+    // Whatever is left of the right run is already in place
+    while (i < n1) {
+        a[k] = buffer[i];
+        out.write(k, a[k]);
+        i++;
+        k++;
+    }
+}
+
+template <typename Sink>
+void mergeSort(std::vector<int>& a, std::vector<int>& buffer, int left, int right, Sink& out) {
+    if (left < right && out.active()) {
+        int mid = left + (right - left) / 2;
+        
+        mergeSort(a, buffer, left, mid, out);
+        mergeSort(a, buffer, mid + 1, right, out);
+        
+        merge(a, buffer, left, mid, right, out);
+    }
+}
+
+template <typename Sink>
+void mergeSort(std::vector<int>& a, Sink& out) {
+    std::vector<int> buffer(a.size() / 2 + 1);
+    mergeSort(a, buffer, 0, static_cast<int>(a.size()) - 1, out);
+}
+
+// Merges src[i, iEnd) with src[j, jEnd) into dst starting at k. Only writes into the
+// visible array are reported as writes; moves into the scratch buffer show up as reads.
+template <typename Sink>
+void mergeRuns(const int* src, int* dst, size_t i, size_t iEnd, size_t j, size_t jEnd, size_t k,
+               bool dstVisible, Sink& out) {
+    while (i < iEnd && j < jEnd) {
+        out.compare(i, j);
+        size_t from = src[j] < src[i] ? j++ : i++;
+        dst[k] = src[from];
+        if (dstVisible) {
+            out.write(k, dst[k]);
+        } else {
+            out.read(from);
+        }
+        k++;
+    }
+    
+    for (size_t from = i < iEnd ? i : j, end = i < iEnd ? iEnd : jEnd; from < end; from++, k++) {
+        dst[k] = src[from];
+        if (dstVisible) {
+            out.write(k, dst[k]);
+        } else {
+            out.read(from);
+        }
+    }
+}
+
+// Sorts a[lo, hi) bottom-up, doubling the run width each pass and ping-ponging between
+// a and buffer instead of copying; the result always ends up back in a
+template <typename Sink>
+void bottomUpMergeSort(std::vector<int>& a, std::vector<int>& buffer, size_t lo, size_t hi, Sink& out) {
+    int* src = a.data();
+    int* dst = buffer.data();
+    bool dstVisible = false;
+    
+    for (size_t width = 1; width < hi - lo && out.active(); width *= 2) {
+        for (size_t left = lo; left < hi; left += 2 * width) {
+            size_t mid = std::min(left + width, hi);
+            size_t right = std::min(left + 2 * width, hi);
+            mergeRuns(src, dst, left, mid, mid, right, left, dstVisible, out);
+        }
+        std::swap(src, dst);
+        dstVisible = !dstVisible;
+    }
+    
+    if (src != a.data()) {
+        for (size_t i = lo; i < hi; i++) {
+            a[i] = buffer[i];
+            out.write(i, a[i]);
+        }
+    }
+}
+
+template <typename Sink>
+void bottomUpMergeSort(std::vector<int>& a, Sink& out) {
+    std::vector<int> buffer(a.size());
+    bottomUpMergeSort(a, buffer, 0, a.size(), out);
+}
+
+// Number of elements taken from A = src[aBegin, aBegin + m) when the first k outputs of a
+// stable merge with B = src[bBegin, bBegin + n) are formed (the co-rank of k)
+inline size_t coRank(const int* src, size_t aBegin, size_t m, size_t bBegin, size_t n, size_t k) {
+    size_t lo = k > n ? k - n : 0;
+    size_t hi = std::min(k, m);
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        if (src[aBegin + i] <= src[bBegin + k - i - 1]) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+// Sorts one contiguous chunk per thread bottom-up, then merges adjacent runs pairwise.
+// Every pairwise merge is split across all threads at co-ranked output positions.
+template <typename Sink>
+void parallelMergeSort(std::vector<int>& a, Sink& out) {
+    size_t n = a.size();
+    unsigned threads = parallelism(n);
+    std::vector<int> buffer(n);
+    
+    std::vector<size_t> bounds(threads + 1);
+    for (unsigned t = 0; t <= threads; t++) {
+        bounds[t] = n * t / threads;
+    }
+    
+    runParallel(threads, out, [&](unsigned t, auto& local) {
+        bottomUpMergeSort(a, buffer, bounds[t], bounds[t + 1], local);
+    });
+    
+    int* src = a.data();
+    int* dst = buffer.data();
+    bool dstVisible = false;
+    
+    while (bounds.size() > 2 && out.active()) {
+        std::vector<size_t> merged;
+        size_t runs = bounds.size() - 1;
+        
+        for (size_t r = 0; r < runs; r += 2) {
+            size_t lo = bounds[r];
+            size_t mid = bounds[std::min(r + 1, runs)];
+            size_t hi = bounds[std::min(r + 2, runs)];
+            merged.push_back(lo);
+            
+            runParallel(threads, out, [&](unsigned t, auto& local) {
+                size_t k0 = (hi - lo) * t / threads;
+                size_t k1 = (hi - lo) * (t + 1) / threads;
+                size_t i0 = coRank(src, lo, mid - lo, mid, hi - mid, k0);
+                size_t i1 = coRank(src, lo, mid - lo, mid, hi - mid, k1);
+                mergeRuns(src, dst, lo + i0, lo + i1, mid + (k0 - i0), mid + (k1 - i1), lo + k0, dstVisible, local);
+            });
+        }
+        
+        merged.push_back(n);
+        bounds.swap(merged);
+        std::swap(src, dst);
+        dstVisible = !dstVisible;
+    }
+    
+    if (src != a.data()) {
+        for (size_t i = 0; i < n; i++) {
+            a[i] = buffer[i];
+            out.write(i, a[i]);
+        }
+    }
+}
+
+// Flipping the sign bit makes ints order correctly as unsigned keys
+inline uint32_t radixKey(int value) {
+    return static_cast<uint32_t>(value) ^ 0x80000000u;
+}
+
+// LSD radix sort on 8-bit digits. One read pass builds all four digit histograms, and
+// passes whose digit is the same for every element are skipped. Each pass scatters
+// stably into the other buffer. With several threads, each thread first recounts its
+// chunk so it can write into its own reserved slots of every bucket.
+// Scatters are recorded as writes at their destination, so the bars show each pass
+// filling its buckets regardless of which buffer holds the data.
+template <typename Sink>
+void radixSort(std::vector<int>& a, Sink& out) {
+    const size_t RADIX = 256;
+    const size_t PASSES = 4;
+    
+    size_t n = a.size();
+    if (n < 2) {
+        return;
+    }
+    
+    unsigned threads = parallelism(n / 65536);
+    std::vector<size_t> bounds(threads + 1);
+    for (unsigned t = 0; t <= threads; t++) {
+        bounds[t] = n * t / threads;
+    }
+    
+    // local[(t * PASSES + pass) * RADIX + digit] for the initial pass over a
+    std::vector<size_t> local(threads * PASSES * RADIX, 0);
+    runParallel(threads, out, [&](unsigned t, auto& sink) {
+        size_t* c = &local[t * PASSES * RADIX];
+        for (size_t i = bounds[t]; i < bounds[t + 1] && sink.active(); i++) {
+            uint32_t key = radixKey(a[i]);
+            c[key & 0xFF]++;
+            c[RADIX + ((key >> 8) & 0xFF)]++;
+            c[2 * RADIX + ((key >> 16) & 0xFF)]++;
+            c[3 * RADIX + (key >> 24)]++;
+            sink.read(i);
+        }
+    });
+    
+    std::vector<size_t> totals(PASSES * RADIX, 0);
+    for (unsigned t = 0; t < threads; t++) {
+        for (size_t k = 0; k < PASSES * RADIX; k++) {
+            totals[k] += local[t * PASSES * RADIX + k];
+        }
+    }
+    
+    std::vector<int> buffer(n);
+    int* src = a.data();
+    int* dst = buffer.data();
+    std::vector<size_t> offsets(threads * RADIX);
+    bool permuted = false;
+    
+    for (size_t pass = 0; pass < PASSES && out.active(); pass++) {
+        const size_t* total = &totals[pass * RADIX];
+        if (std::find(total, total + RADIX, n) != total + RADIX) {
+            continue;
+        }
+        unsigned shift = static_cast<unsigned>(pass * 8);
+        
+        // Chunks of a permuted array hold different keys than the first pass counted
+        if (threads > 1 && permuted) {
+            std::fill(offsets.begin(), offsets.end(), 0);
+            runParallel(threads, out, [&](unsigned t, auto& sink) {
+                size_t* c = &offsets[t * RADIX];
+                for (size_t i = bounds[t]; i < bounds[t + 1] && sink.active(); i++) {
+                    c[(radixKey(src[i]) >> shift) & 0xFF]++;
+                    sink.read(i);
+                }
+            });
+        } else {
+            for (unsigned t = 0; t < threads; t++) {
+                std::copy_n(&local[(t * PASSES + pass) * RADIX], RADIX, &offsets[t * RADIX]);
+            }
+        }
+        
+        // Thread t's digit-d elements go after all smaller digits and after
+        // the digit-d elements of the threads before it
+        size_t next = 0;
+        for (size_t d = 0; d < RADIX; d++) {
+            for (unsigned t = 0; t < threads; t++) {
+                size_t count = offsets[t * RADIX + d];
+                offsets[t * RADIX + d] = next;
+                next += count;
+            }
+        }
+        
+        runParallel(threads, out, [&](unsigned t, auto& sink) {
+            size_t* offset = &offsets[t * RADIX];
+            for (size_t i = bounds[t]; i < bounds[t + 1] && sink.active(); i++) {
+                size_t k = offset[(radixKey(src[i]) >> shift) & 0xFF]++;
+                dst[k] = src[i];
+                sink.read(i);
+                sink.write(k, dst[k]);
+            }
+        });
+        std::swap(src, dst);
+        permuted = true;
+    }
+    
+    if (src != a.data()) {
+        for (size_t i = 0; i < n; i++) {
+            a[i] = buffer[i];
+            out.write(i, a[i]);
+        }
+    }
+}
+
+// Value ranges up to this size are counting sorted; wider ranges are radix sorted
+const size_t COUNTING_SORT_MAX_RANGE = size_t(1) << 22;
+
+// Adds the histogram of a[begin, end), offset by minValue, to counts. Cache-sized ranges
+// count into four interleaved sub-histograms so runs of equal keys don't serialize on a
+// single counter.
+template <typename Sink>
+void countValues(const std::vector<int>& a, size_t begin, size_t end, int minValue,
+                 std::vector<uint32_t>& counts, Sink& out) {
+    size_t range = counts.size();
+    size_t i = begin;
+    
+    if (range <= 65536 && end - begin >= 4 * range) {
+        std::vector<uint32_t> sub(4 * range, 0);
+        for (; i + 4 <= end && out.active(); i += 4) {
+            sub[a[i] - minValue]++;
+            sub[range + a[i + 1] - minValue]++;
+            sub[2 * range + a[i + 2] - minValue]++;
+            sub[3 * range + a[i + 3] - minValue]++;
+            out.read(i);
+            out.read(i + 1);
+            out.read(i + 2);
+            out.read(i + 3);
+        }
+        for (size_t v = 0; v < range; v++) {
+            counts[v] += sub[v] + sub[range + v] + sub[2 * range + v] + sub[3 * range + v];
+        }
+    }
+    
+    for (; i < end && out.active(); i++) {
+        counts[a[i] - minValue]++;
+        out.read(i);
+    }
+}
+
+// Counts every value, then rewrites the array bucket by bucket. Threads histogram their
+// own chunk and fill their own slice of the output.
+template <typename Sink>
+void countingSort(std::vector<int>& a, Sink& out) {
+    size_t n = a.size();
+    if (n < 2) {
+        return;
+    }
+    
+    int minValue = a[0];
+    int maxValue = a[0];
+    for (size_t i = 0; i < n; i++) {
+        minValue = std::min(minValue, a[i]);
+        maxValue = std::max(maxValue, a[i]);
+        out.read(i);
+    }
+    
+    size_t range = static_cast<size_t>(static_cast<int64_t>(maxValue) - minValue) + 1;
+    if (range > COUNTING_SORT_MAX_RANGE) {
+        radixSort(a, out);
+        return;
+    }
+    
+    // Per-thread histograms only pay off when they are small next to the input
+    unsigned threads = range <= n / 64 ? parallelism(n / 65536) : 1;
+    std::vector<std::vector<uint32_t>> counts(threads, std::vector<uint32_t>(range, 0));
+    
+    runParallel(threads, out, [&](unsigned t, auto& local) {
+        countValues(a, n * t / threads, n * (t + 1) / threads, minValue, counts[t], local);
+    });
+    
+    // starts[v] is the first output position of value minValue + v
+    std::vector<size_t> starts(range + 1, 0);
+    for (size_t v = 0; v < range; v++) {
+        size_t total = 0;
+        for (unsigned t = 0; t < threads; t++) {
+            total += counts[t][v];
+        }
+        starts[v + 1] = starts[v] + total;
+    }
+    
+    runParallel(threads, out, [&](unsigned t, auto& local) {
+        size_t k = n * t / threads;
+        size_t end = n * (t + 1) / threads;
+        size_t v = std::upper_bound(starts.begin(), starts.end(), k) - starts.begin() - 1;
+        
+        for (; k < end && local.active(); k++) {
+            while (starts[v + 1] <= k) {
+                v++;
+            }
+            a[k] = minValue + static_cast<int>(v);
+            local.write(k, a[k]);
+        }
+    });
+}
+
+inline unsigned countTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+}
+
+// Widest vector instruction set usable on this CPU
+enum class SimdLevel {
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+inline SimdLevel detectSimdLevel() {
+#if ALGOVIS_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osAvx) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return avx2 ? SimdLevel::AVX2 : sse41 ? SimdLevel::SSE41 : SimdLevel::SCALAR;
+#elif ALGOVIS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    return __builtin_cpu_supports("sse4.1") ? SimdLevel::SSE41 : SimdLevel::SCALAR;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+inline SimdLevel simdLevel() {
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+// Bitonic merge of a[lo, lo + n) for any n: compare-exchange across the largest power
+// of two below n, then merge both sides
+template <typename Sink>
+void bitonicMerge(std::vector<int>& a, size_t lo, size_t n, bool ascending, Sink& out) {
+    if (n < 2 || !out.active()) {
+        return;
+    }
+    
+    size_t m = 1;
+    while (m * 2 < n) {
+        m *= 2;
+    }
+    
+    for (size_t i = lo; i < lo + n - m; i++) {
+        out.compare(i, i + m);
+        if (ascending ? a[i] > a[i + m] : a[i] < a[i + m]) {
+            std::swap(a[i], a[i + m]);
+            out.swap(i, i + m);
+        }
+    }
+    
+    bitonicMerge(a, lo, m, ascending, out);
+    bitonicMerge(a, lo + m, n - m, ascending, out);
+}
+
+template <typename Sink>
+void bitonicSort(std::vector<int>& a, size_t lo, size_t n, bool ascending, Sink& out) {
+    if (n < 2) {
+        return;
+    }
+    
+    size_t m = n / 2;
+    bitonicSort(a, lo, m, !ascending, out);
+    bitonicSort(a, lo + m, n - m, ascending, out);
+    bitonicMerge(a, lo, n, ascending, out);
+}
+
+// Recorded runs step through the network one compare-exchange at a time
+template <typename Sink>
+void bitonicSort(std::vector<int>& a, Sink& out) {
+    bitonicSort(a, 0, a.size(), true, out);
+}
+
+// Kernels for the power-of-two bitonic network. exchange() runs one stage (stride j of
+// the k-element merge) over a[begin, end) for strides of at least WIDTH; inRegister()
+// runs all stages of stride below WIDTH with the vector held in a register.
+struct BitonicScalar {
+    static const size_t WIDTH = 1;
+    
+    static void exchange(int* a, size_t begin, size_t end, size_t j, size_t k) {
+        for (size_t i = begin; i < end; i += 2 * j) {
+            bool ascending = (i & k) == 0;
+            for (size_t p = i; p < i + j; p++) {
+                int lo = std::min(a[p], a[p + j]);
+                int hi = std::max(a[p], a[p + j]);
+                a[p] = ascending ? lo : hi;
+                a[p + j] = ascending ? hi : lo;
+            }
+        }
+    }
+    
+    static void exchangeTwo(int* a, size_t begin, size_t end, size_t j, size_t k) {
+        exchange(a, begin, end, j, k);
+        exchange(a, begin, end, j / 2, k);
+    }
+    
+    static void inRegister(int*, size_t, size_t, size_t) {}
+};
+
+#if ALGOVIS_X86
+struct BitonicSse41 {
+    static const size_t WIDTH = 4;
+    
+    ALGOVIS_TARGET("sse4.1")
+    static void exchange(int* a, size_t begin, size_t end, size_t j, size_t k) {
+        for (size_t i = begin; i < end; i += 2 * j) {
+            bool ascending = (i & k) == 0;
+            for (size_t p = i; p < i + j; p += WIDTH) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + p));
+                __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + p + j));
+                __m128i lo = _mm_min_epi32(x, y);
+                __m128i hi = _mm_max_epi32(x, y);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + p), ascending ? lo : hi);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + p + j), ascending ? hi : lo);
+            }
+        }
+    }
+    
+    // Stages j and j / 2 in one sweep over memory
+    ALGOVIS_TARGET("sse4.1")
+    static void exchangeTwo(int* a, size_t begin, size_t end, size_t j, size_t k) {
+        size_t h = j / 2;
+        for (size_t i = begin; i < end; i += 2 * j) {
+            bool ascending = (i & k) == 0;
+            for (size_t p = i; p < i + h; p += WIDTH) {
+                __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + p));
+                __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + p + h));
+                __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + p + j));
+                __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + p + j + h));
+                __m128i lo0 = _mm_min_epi32(x0, x2), hi0 = _mm_max_epi32(x0, x2);
+                __m128i lo1 = _mm_min_epi32(x1, x3), hi1 = _mm_max_epi32(x1, x3);
+                __m128i first = ascending ? lo0 : hi0, second = ascending ? lo1 : hi1;
+                __m128i third = ascending ? hi0 : lo0, fourth = ascending ? hi1 : lo1;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + p), ascending ? _mm_min_epi32(first, second) : _mm_max_epi32(first, second));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + p + h), ascending ? _mm_max_epi32(first, second) : _mm_min_epi32(first, second));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + p + j), ascending ? _mm_min_epi32(third, fourth) : _mm_max_epi32(third, fourth));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + p + j + h), ascending ? _mm_max_epi32(third, fourth) : _mm_min_epi32(third, fourth));
+            }
+        }
+    }
+    
+    ALGOVIS_TARGET("sse4.1")
+    static void inRegister(int* a, size_t begin, size_t end, size_t k) {
+        const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lower2 = _mm_cmpeq_epi32(_mm_and_si128(lane, _mm_set1_epi32(2)), zero);
+        __m128i lower1 = _mm_cmpeq_epi32(_mm_and_si128(lane, _mm_set1_epi32(1)), zero);
+        // Lanes that sort descending: per lane below one register, per register above
+        __m128i laneDescending = _mm_xor_si128(
+            _mm_cmpeq_epi32(_mm_and_si128(lane, _mm_set1_epi32(static_cast<int>(k & 3))), zero),
+            _mm_set1_epi32(-1));
+        
+        for (size_t i = begin; i < end; i += WIDTH) {
+            __m128i descending = k < WIDTH ? laneDescending : _mm_set1_epi32((i & k) ? -1 : 0);
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            
+            if (k >= 4) {
+                __m128i partner = _mm_shuffle_epi32(v, 0x4E);
+                v = _mm_blendv_epi8(_mm_max_epi32(v, partner), _mm_min_epi32(v, partner),
+                                    _mm_xor_si128(lower2, descending));
+            }
+            __m128i partner = _mm_shuffle_epi32(v, 0xB1);
+            v = _mm_blendv_epi8(_mm_max_epi32(v, partner), _mm_min_epi32(v, partner),
+                                _mm_xor_si128(lower1, descending));
+            
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), v);
+        }
+    }
+};
+
+struct BitonicAvx2 {
+    static const size_t WIDTH = 8;
+    
+    ALGOVIS_TARGET("avx2")
+    static void exchange(int* a, size_t begin, size_t end, size_t j, size_t k) {
+        for (size_t i = begin; i < end; i += 2 * j) {
+            bool ascending = (i & k) == 0;
+            for (size_t p = i; p < i + j; p += WIDTH) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p));
+                __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p + j));
+                __m256i lo = _mm256_min_epi32(x, y);
+                __m256i hi = _mm256_max_epi32(x, y);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + p), ascending ? lo : hi);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + p + j), ascending ? hi : lo);
+            }
+        }
+    }
+    
+    // Stages j and j / 2 in one sweep over memory
+    ALGOVIS_TARGET("avx2")
+    static void exchangeTwo(int* a, size_t begin, size_t end, size_t j, size_t k) {
+        size_t h = j / 2;
+        for (size_t i = begin; i < end; i += 2 * j) {
+            bool ascending = (i & k) == 0;
+            for (size_t p = i; p < i + h; p += WIDTH) {
+                __m256i x0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p));
+                __m256i x1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p + h));
+                __m256i x2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p + j));
+                __m256i x3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p + j + h));
+                __m256i lo0 = _mm256_min_epi32(x0, x2), hi0 = _mm256_max_epi32(x0, x2);
+                __m256i lo1 = _mm256_min_epi32(x1, x3), hi1 = _mm256_max_epi32(x1, x3);
+                __m256i first = ascending ? lo0 : hi0, second = ascending ? lo1 : hi1;
+                __m256i third = ascending ? hi0 : lo0, fourth = ascending ? hi1 : lo1;
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + p), ascending ? _mm256_min_epi32(first, second) : _mm256_max_epi32(first, second));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + p + h), ascending ? _mm256_max_epi32(first, second) : _mm256_min_epi32(first, second));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + p + j), ascending ? _mm256_min_epi32(third, fourth) : _mm256_max_epi32(third, fourth));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + p + j + h), ascending ? _mm256_max_epi32(third, fourth) : _mm256_min_epi32(third, fourth));
+            }
+        }
+    }
+    
+    ALGOVIS_TARGET("avx2")
+    static void inRegister(int* a, size_t begin, size_t end, size_t k) {
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i lower4 = _mm256_cmpeq_epi32(_mm256_and_si256(lane, _mm256_set1_epi32(4)), zero);
+        __m256i lower2 = _mm256_cmpeq_epi32(_mm256_and_si256(lane, _mm256_set1_epi32(2)), zero);
+        __m256i lower1 = _mm256_cmpeq_epi32(_mm256_and_si256(lane, _mm256_set1_epi32(1)), zero);
+        // Lanes that sort descending: per lane below one register, per register above
+        __m256i laneDescending = _mm256_xor_si256(
+            _mm256_cmpeq_epi32(_mm256_and_si256(lane, _mm256_set1_epi32(static_cast<int>(k & 7))), zero),
+            _mm256_set1_epi32(-1));
+        
+        for (size_t i = begin; i < end; i += WIDTH) {
+            __m256i descending = k < WIDTH ? laneDescending : _mm256_set1_epi32((i & k) ? -1 : 0);
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i partner;
+            
+            if (k >= 8) {
+                partner = _mm256_permute2x128_si256(v, v, 0x01);
+                v = _mm256_blendv_epi8(_mm256_max_epi32(v, partner), _mm256_min_epi32(v, partner),
+                                       _mm256_xor_si256(lower4, descending));
+            }
+            if (k >= 4) {
+                partner = _mm256_shuffle_epi32(v, 0x4E);
+                v = _mm256_blendv_epi8(_mm256_max_epi32(v, partner), _mm256_min_epi32(v, partner),
+                                       _mm256_xor_si256(lower2, descending));
+            }
+            partner = _mm256_shuffle_epi32(v, 0xB1);
+            v = _mm256_blendv_epi8(_mm256_max_epi32(v, partner), _mm256_min_epi32(v, partner),
+                                   _mm256_xor_si256(lower1, descending));
+            
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), v);
+        }
+    }
+};
+#endif
+
+// Power-of-two bitonic network. Strides of at least BLOCK run as whole-array passes,
+// two stages per pass; the remaining stages of each merge run block by block while the block is in L1.
+template <typename Kernel>
+void bitonicNetwork(int* a, size_t n) {
+    const size_t BLOCK = 4096;
+    size_t block = std::min(BLOCK, n);
+    
+    for (size_t k = 2; k <= n; k *= 2) {
+        size_t j = k / 2;
+        while (j >= block) {
+            if (j / 2 >= block) {
+                Kernel::exchangeTwo(a, 0, n, j, k);
+                j /= 4;
+            } else {
+                Kernel::exchange(a, 0, n, j, k);
+                j /= 2;
+            }
+        }
+        
+        for (size_t b = 0; b < n; b += block) {
+            for (size_t stride = j; stride >= Kernel::WIDTH; stride /= 2) {
+                Kernel::exchange(a, b, b + block, stride, k);
+            }
+            Kernel::inRegister(a, b, b + block, k);
+        }
+    }
+}
+
+// Unrecorded runs (timing) take the vectorized network over the array padded to a
+// power of two, using the widest kernel the CPU supports
+inline void bitonicSort(std::vector<int>& a, NullSink&) {
+    size_t n = a.size();
+    if (n < 2) {
+        return;
+    }
+    
+    size_t padded = 1;
+    while (padded < n) {
+        padded *= 2;
+    }
+    
+    std::vector<int> work;
+    int* data = a.data();
+    if (padded != n) {
+        work.assign(padded, INT_MAX);
+        std::copy(a.begin(), a.end(), work.begin());
+        data = work.data();
+    }
+    
+#if ALGOVIS_X86
+    SimdLevel level = simdLevel();
+    if (level == SimdLevel::AVX2 && padded >= BitonicAvx2::WIDTH) {
+        bitonicNetwork<BitonicAvx2>(data, padded);
+    } else if (level == SimdLevel::SSE41 && padded >= BitonicSse41::WIDTH) {
+        bitonicNetwork<BitonicSse41>(data, padded);
+    } else {
+        bitonicNetwork<BitonicScalar>(data, padded);
+    }
+#else
+    bitonicNetwork<BitonicScalar>(data, padded);
+#endif
+    
+    if (padded != n) {
+        std::copy(work.begin(), work.begin() + n, a.begin());
+    }
+}
+
+// Pathfinding Algorithms
+// Cells are identified by their row-major index y * width + x
+template <typename Sink>
+void reconstructPath(const GridMap& grid, const SearchScratch& scratch, Sink& out) {
+    uint32_t current = static_cast<uint32_t>(grid.end);
+    uint32_t start = static_cast<uint32_t>(grid.start);
+    while (current != start) {
+        uint32_t prev = scratch.parent[current];
+        if (prev != start) {
+            out.path(prev);
+        }
+        current = prev;
+    }
+}
+
+// Directions: up, right, down, left
+const sf::Vector2i CARDINAL_DIRECTIONS[4] = {
+    sf::Vector2i(0, -1), sf::Vector2i(1, 0),
+    sf::Vector2i(0, 1), sf::Vector2i(-1, 0)
+};
+
+// Directions: up, right, down, left + diagonals
+const sf::Vector2i ALL_DIRECTIONS[8] = {
+    sf::Vector2i(0, -1), sf::Vector2i(1, 0),
+    sf::Vector2i(0, 1), sf::Vector2i(-1, 0),
+    sf::Vector2i(1, -1), sf::Vector2i(1, 1),
+    sf::Vector2i(-1, 1), sf::Vector2i(-1, -1)
+};
+
+// Move costs: sqrt(2) * 10 rounded for diagonal steps
+const uint32_t CARDINAL_COST = 10;
+const uint32_t DIAGONAL_COST = 14;
+
+inline uint32_t moveCost(const sf::Vector2i& dir) {
+    return dir.x != 0 && dir.y != 0 ? DIAGONAL_COST : CARDINAL_COST;
+}
+
+template <typename Sink>
+void bfs(const GridMap& grid, SearchScratch& scratch, Sink& out) {
+    scratch.reset(grid.cellCount());
+    std::vector<uint32_t>& queue = scratch.frontier;
+    size_t head = 0;
+    
+    queue.push_back(grid.start);
+    out.push(grid.start);
+    scratch.markVisited(grid.start);
+    
+    bool foundPath = false;
+    
+    while (head < queue.size() && out.active()) {
+        uint32_t current = queue[head++];
+        out.pop(current);
+        
+        if (current == static_cast<uint32_t>(grid.end)) {
+            foundPath = true;
+            break;
+        }
+        
+        if (current != static_cast<uint32_t>(grid.start)) {
+            out.visit(current);
+        }
+        
+        int x = grid.xOf(current);
+        int y = grid.yOf(current);
+        
+        for (const auto& dir : CARDINAL_DIRECTIONS) {
+            // Check if next position is valid
+            if (!grid.contains(x + dir.x, y + dir.y)) {
+                continue;
+            }
+            
+            uint32_t next = current + dir.y * grid.width + dir.x;
+            if (!grid.isObstacle(next) && scratch.markVisited(next)) {
+                queue.push_back(next);
+                out.push(next);
+                scratch.parent[next] = current;
+            }
+        }
+    }
+    
+    if (foundPath) {
+        reconstructPath(grid, scratch, out);
+    }
+}
+
+template <typename Sink>
+void dfs(const GridMap& grid, SearchScratch& scratch, Sink& out) {
+    scratch.reset(grid.cellCount());
+    std::vector<uint32_t>& stack = scratch.frontier;
+    
+    stack.push_back(grid.start);
+    out.push(grid.start);
+    
+    bool foundPath = false;
+    
+    while (!stack.empty() && out.active()) {
+        uint32_t current = stack.back();
+        stack.pop_back();
+        out.pop(current);
+        
+        if (current == static_cast<uint32_t>(grid.end)) {
+            foundPath = true;
+            break;
+        }
+        
+        if (!scratch.markVisited(current)) {
+            continue;
+        }
+        
+        if (current != static_cast<uint32_t>(grid.start)) {
+            out.visit(current);
+        }
+        
+        int x = grid.xOf(current);
+        int y = grid.yOf(current);
+        
+        for (const auto& dir : CARDINAL_DIRECTIONS) {
+            // Check if next position is valid
+            if (!grid.contains(x + dir.x, y + dir.y)) {
+                continue;
+            }
+            
+            uint32_t next = current + dir.y * grid.width + dir.x;
+            if (!grid.isObstacle(next) && !scratch.isVisited(next)) {
+                stack.push_back(next);
+                out.push(next);
+                scratch.parent[next] = current;
+            }
+        }
+    }
+    
+    if (foundPath) {
+        reconstructPath(grid, scratch, out);
+    }
+}
+
+template <typename Sink>
+void dijkstra(const GridMap& grid, SearchScratch& scratch, Sink& out) {
+    scratch.reset(grid.cellCount());
+    scratch.resetDistances(grid.cellCount());
+    
+    // Min-heap of (distance << 32 | cell) keys kept in reusable scratch storage
+    std::vector<uint64_t>& heap = scratch.heap;
+    auto pushHeap = [&heap](uint32_t dist, uint32_t cell) {
+        heap.push_back(static_cast<uint64_t>(dist) << 32 | cell);
+        std::push_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+    };
+    
+    // Start with distance 0 for the start point
+    pushHeap(0, grid.start);
+    out.push(grid.start);
+    scratch.distance[grid.start] = 0;
+    
+    bool foundPath = false;
+    
+    while (!heap.empty() && out.active()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+        uint32_t dist = static_cast<uint32_t>(heap.back() >> 32);
+        uint32_t current = static_cast<uint32_t>(heap.back());
+        heap.pop_back();
+        out.pop(current);
+        
+        if (current == static_cast<uint32_t>(grid.end)) {
+            foundPath = true;
+            break;
+        }
+        
+        // Skip if we've found a better path already
+        if (dist > scratch.distance[current]) {
+            continue;
+        }
+        
+        if (current != static_cast<uint32_t>(grid.start)) {
+            out.visit(current);
+        }
+        
+        int x = grid.xOf(current);
+        int y = grid.yOf(current);
+        
+        for (const auto& dir : ALL_DIRECTIONS) {
+            // Check if next position is valid
+            if (!grid.contains(x + dir.x, y + dir.y)) {
+                continue;
+            }
+            
+            uint32_t next = current + dir.y * grid.width + dir.x;
+            if (grid.isObstacle(next)) {
+                continue;
+            }
+            
+            uint32_t newDist = dist + moveCost(dir);
+            
+            if (newDist < scratch.distance[next]) {
+                scratch.distance[next] = newDist;
+                scratch.parent[next] = current;
+                pushHeap(newDist, next);
+                out.push(next);
+            }
+        }
+    }
+    
+    if (foundPath) {
+        reconstructPath(grid, scratch, out);
+    }
+}
+
+// Bit-parallel BFS. Each row of the grid is a run of stride 64-bit words (padding bits
+// are never free), so a whole frontier word expands with two shifts and two word moves:
+// bit i + 1 / i - 1 are the right / left neighbours, the same word one row up or down
+// the vertical ones. Only the words of the current frontier are touched each level.
+// Instead of per-cell distances each side keeps its BFS level mod 3 in two bit planes;
+// neighbouring cells differ by at most one level, so that is enough to walk back.
+inline uint32_t bitCell(const GridMap& grid, const SearchScratch& scratch, size_t word, unsigned bit) {
+    size_t y = word >> scratch.bitStrideShift;
+    size_t x = (word & (scratch.bitStride - 1)) * 64 + bit;
+    return static_cast<uint32_t>(y * grid.width + x);
+}
+
+inline void initBitSide(const GridMap& grid, SearchScratch& scratch, int side, uint32_t origin) {
+    size_t word = (static_cast<size_t>(grid.yOf(origin)) << scratch.bitStrideShift) + grid.xOf(origin) / 64;
+    uint64_t bit = uint64_t(1) << (grid.xOf(origin) % 64);
+    scratch.bits[word].seen[side] = bit;
+    scratch.wave[side].assign(1, std::make_pair(static_cast<uint32_t>(word), bit));
+}
+
+inline void initBitSearch(const GridMap& grid, SearchScratch& scratch) {
+    // A power-of-two stride turns the word -> row / column splits into shifts and masks
+    size_t stride = 1;
+    scratch.bitStrideShift = 0;
+    while (stride * 64 < static_cast<size_t>(grid.width)) {
+        stride *= 2;
+        scratch.bitStrideShift++;
+    }
+    scratch.bitStride = stride;
+    scratch.bits.assign(stride * grid.height, BitWord());
+    scratch.touched.clear();
+    
+    for (int y = 0; y < grid.height; y++) {
+        const uint8_t* row = &grid.cells[grid.index(0, y)];
+        BitWord* words = &scratch.bits[static_cast<size_t>(y) << scratch.bitStrideShift];
+        for (int x = 0; x < grid.width; x++) {
+            words[x / 64].free |= static_cast<uint64_t>(row[x] != 1) << (x % 64);
+        }
+    }
+    
+    initBitSide(grid, scratch, 0, static_cast<uint32_t>(grid.start));
+    initBitSide(grid, scratch, 1, static_cast<uint32_t>(grid.end));
+}
+
+// Expands one side's frontier by a level. Returns a newly reached cell the other side
+// has already seen, or UINT32_MAX.
+template <typename Sink>
+uint32_t expandBitLevel(const GridMap& grid, SearchScratch& scratch, int side, uint32_t level, Sink& out) {
+    size_t stride = scratch.bitStride;
+    std::vector<BitWord>& bits = scratch.bits;
+    std::vector<uint32_t>& touched = scratch.touched;
+    
+    // Branch-free: whether a word gets new bits is data dependent and mispredicts badly
+    size_t count = 0;
+    touched.resize(5 * scratch.wave[side].size());
+    auto reach = [&](size_t word, uint64_t reached) {
+        BitWord& w = bits[word];
+        touched[count] = static_cast<uint32_t>(word);
+        count += (w.next == 0) & (reached != 0);
+        w.next |= reached;
+    };
+    
+    for (const auto& entry : scratch.wave[side]) {
+        size_t word = entry.first;
+        uint64_t frontier = entry.second;
+        size_t column = word & (stride - 1);
+        
+        reach(word, (frontier << 1) | (frontier >> 1));
+        if (column + 1 < stride) {
+            reach(word + 1, frontier >> 63);
+        }
+        if (column > 0) {
+            reach(word - 1, frontier << 63);
+        }
+        if (word >= stride) {
+            reach(word - stride, frontier);
+        }
+        if (word + stride < bits.size()) {
+            reach(word + stride, frontier);
+        }
+    }
+    
+    std::vector<std::pair<uint32_t, uint64_t>>& wave = scratch.nextWave;
+    wave.resize(count);
+    size_t waveSize = 0;
+    uint32_t meet = UINT32_MAX;
+    uint64_t plane0 = (level % 3) & 1 ? ~uint64_t(0) : 0;
+    uint64_t plane1 = (level % 3) & 2 ? ~uint64_t(0) : 0;
+    
+    for (size_t t = 0; t < count; t++) {
+        uint32_t word = touched[t];
+        BitWord& w = bits[word];
+        uint64_t reached = w.next & w.free & ~w.seen[side];
+        w.next = 0;
+        w.seen[side] |= reached;
+        w.level[side][0] |= reached & plane0;
+        w.level[side][1] |= reached & plane1;
+        wave[waveSize] = std::make_pair(word, reached);
+        waveSize += reached != 0;
+        
+        uint64_t hit = reached & w.seen[1 - side];
+        if (hit && meet == UINT32_MAX) {
+            meet = bitCell(grid, scratch, word, countTrailingZeros(hit));
+        }
+        
+        if (RecordsSteps<Sink>::value) {
+            for (uint64_t rest = reached & ~w.seen[1 - side]; rest; rest &= rest - 1) {
+                out.visit(bitCell(grid, scratch, word, countTrailingZeros(rest)));
+            }
+        }
+    }
+    
+    wave.resize(waveSize);
+    scratch.wave[side].swap(wave);
+    return meet;
+}
+
+// Emits the path from cell back to the origin of side, stepping each time to the
+// neighbour seen one level earlier (mod 3); neither end is emitted
+template <typename Sink>
+void walkBitLevels(const GridMap& grid, const SearchScratch& scratch, int side, uint32_t cell,
+                   uint32_t origin, Sink& out) {
+    auto levelOf = [&](int x, int y, bool& seen) {
+        const BitWord& w = scratch.bits[(static_cast<size_t>(y) << scratch.bitStrideShift) + x / 64];
+        unsigned bit = x % 64;
+        seen = (w.seen[side] >> bit) & 1;
+        return static_cast<uint32_t>(((w.level[side][0] >> bit) & 1) | (((w.level[side][1] >> bit) & 1) << 1));
+    };
+    
+    while (cell != origin && out.active()) {
+        int x = grid.xOf(cell);
+        int y = grid.yOf(cell);
+        bool seen;
+        uint32_t previous = (levelOf(x, y, seen) + 2) % 3;
+        
+        for (const auto& dir : CARDINAL_DIRECTIONS) {
+            if (grid.contains(x + dir.x, y + dir.y) && levelOf(x + dir.x, y + dir.y, seen) == previous && seen) {
+                cell = static_cast<uint32_t>(grid.index(x + dir.x, y + dir.y));
+                break;
+            }
+        }
+        
+        if (cell != origin) {
+            out.path(cell);
+        }
+    }
+}
+
+// Bit-parallel BFS from the start; the end cell is the only cell "seen" by the other side
+template <typename Sink>
+void bitBfs(const GridMap& grid, SearchScratch& scratch, Sink& out) {
+    initBitSearch(grid, scratch);
+    
+    uint32_t meet = grid.start == grid.end ? static_cast<uint32_t>(grid.end) : UINT32_MAX;
+    for (uint32_t level = 1; meet == UINT32_MAX && !scratch.wave[0].empty() && out.active(); level++) {
+        meet = expandBitLevel(grid, scratch, 0, level, out);
+    }
+    
+    if (meet != UINT32_MAX) {
+        walkBitLevels(grid, scratch, 0, meet, static_cast<uint32_t>(grid.start), out);
+    }
+}
+
+// Bit-parallel BFS from both ends, always advancing the side with the smaller frontier.
+// The first cell one side reaches that the other has seen lies on a shortest path.
+template <typename Sink>
+void bidirectionalBfs(const GridMap& grid, SearchScratch& scratch, Sink& out) {
+    initBitSearch(grid, scratch);
+    
+    uint32_t levels[2] = {0, 0};
+    uint32_t meet = grid.start == grid.end ? static_cast<uint32_t>(grid.end) : UINT32_MAX;
+    while (meet == UINT32_MAX && !scratch.wave[0].empty() && !scratch.wave[1].empty() && out.active()) {
+        int side = scratch.wave[0].size() <= scratch.wave[1].size() ? 0 : 1;
+        meet = expandBitLevel(grid, scratch, side, ++levels[side], out);
+    }
+    
+    if (meet != UINT32_MAX) {
+        uint32_t start = static_cast<uint32_t>(grid.start);
+        uint32_t end = static_cast<uint32_t>(grid.end);
+        if (meet != start && meet != end) {
+            out.path(meet);
+        }
+        walkBitLevels(grid, scratch, 0, meet, start, out);
+        walkBitLevels(grid, scratch, 1, meet, end, out);
+    }
+}
+
+// Level-synchronous BFS: each level's frontier is split evenly across the workers, which
+// claim newly reached cells atomically and collect them in thread-local buffers that are
+// concatenated into the next frontier between barriers. Cells are recorded as visited by
+// the thread that discovers them, one segment per thread and level, so the replay shows
+// the waves in order and tints every cell with its discoverer.
+template <typename Sink>
+void parallelBfs(const GridMap& grid, SearchScratch& scratch, Sink& out) {
+    const size_t GRAIN = 256; // cells per worker before another thread pays off
+    
+    size_t cellCount = grid.cellCount();
+    scratch.reset(cellCount);
+    scratch.resetClaims(cellCount);
+    scratch.nextFrontier.clear();
+    std::vector<uint32_t>* levels[2] = {&scratch.frontier, &scratch.nextFrontier};
+    
+    uint32_t start = static_cast<uint32_t>(grid.start);
+    uint32_t end = static_cast<uint32_t>(grid.end);
+    scratch.frontier.push_back(start);
+    scratch.claim(start, false);
+    if (start == end) {
+        return;
+    }
+    
+    unsigned threads = parallelism(cellCount / GRAIN);
+    bool shared = threads > 1;
+    SpinBarrier barrier(threads);
+    std::vector<std::vector<uint32_t>> discovered(threads);
+    std::vector<size_t> offsets(threads + 1, 0);
+    std::atomic<bool> found(false);
+    bool done = false;
+    
+    runParallel(threads, out, [&](unsigned t, auto& local) {
+        std::vector<uint32_t>& mine = discovered[t];
+        
+        for (uint32_t level = 0;; level++) {
+            const std::vector<uint32_t>& current = *levels[level & 1];
+            std::vector<uint32_t>& next = *levels[(level + 1) & 1];
+            beginSegment(local, static_cast<uint64_t>(level) * threads + t);
+            
+            size_t first = current.size() * t / threads;
+            size_t last = current.size() * (t + 1) / threads;
+            for (size_t i = first; i < last; i++) {
+                uint32_t cell = current[i];
+                int x = grid.xOf(cell);
+                int y = grid.yOf(cell);
+                
+                for (const auto& dir : CARDINAL_DIRECTIONS) {
+                    if (!grid.contains(x + dir.x, y + dir.y)) {
+                        continue;
+                    }
+                    
+                    uint32_t neighbor = cell + dir.y * grid.width + dir.x;
+                    if (!grid.isObstacle(neighbor) && scratch.claim(neighbor, shared)) {
+                        scratch.parent[neighbor] = cell;
+                        mine.push_back(neighbor);
+                        if (neighbor == end) {
+                            found.store(true, std::memory_order_relaxed);
+                        } else {
+                            local.visit(neighbor);
+                        }
+                    }
+                }
+            }
+            barrier.wait();
+            
+            // Thread 0 lays out the next frontier while the others wait
+            if (t == 0) {
+                for (unsigned u = 0; u < threads; u++) {
+                    offsets[u + 1] = offsets[u] + discovered[u].size();
+                }
+                next.resize(offsets[threads]);
+                done = offsets[threads] == 0 || found.load(std::memory_order_relaxed) || !local.active();
+            }
+            barrier.wait();
+            if (done) {
+                break;
+            }
+            
+            std::copy(mine.begin(), mine.end(), next.begin() + offsets[t]);
+            mine.clear();
+            barrier.wait();
+        }
+    });
+    
+    if (found.load(std::memory_order_relaxed)) {
+        reconstructPath(grid, scratch, out);
+    }
+}
+
+// Dijkstra with Dial's bucket queue: edge costs are at most DIAGONAL_COST, so every
+// tentative distance lies within DIAGONAL_COST of the one being settled and a ring of
+// buckets indexed by distance modulo its size replaces the heap. Pushes and pops are
+// O(1); stale entries are skipped when popped, as in dijkstra().
+template <typename Sink>
+void dialDijkstra(const GridMap& grid, SearchScratch& scratch, Sink& out) {
+    const uint32_t BUCKETS = 16; // power of two above DIAGONAL_COST
+    static_assert(DIAGONAL_COST < BUCKETS, "bucket ring must span the largest move cost");
+    
+    scratch.reset(grid.cellCount());
+    scratch.resetDistances(grid.cellCount());
+    
+    std::vector<std::vector<uint32_t>>& buckets = scratch.buckets;
+    buckets.resize(BUCKETS);
+    for (auto& bucket : buckets) {
+        bucket.clear();
+    }
+    
+    buckets[0].push_back(grid.start);
+    out.push(grid.start);
+    scratch.distance[grid.start] = 0;
+    size_t pending = 1;
+    uint32_t dist = 0;
+    
+    bool foundPath = false;
+    
+    while (pending > 0 && out.active()) {
+        std::vector<uint32_t>& bucket = buckets[dist & (BUCKETS - 1)];
+        if (bucket.empty()) {
+            dist++;
+            continue;
+        }
+        
+        uint32_t current = bucket.back();
+        bucket.pop_back();
+        pending--;
+        out.pop(current);
+        
+        if (current == static_cast<uint32_t>(grid.end)) {
+            foundPath = true;
+            break;
+        }
+        
+        // Skip if we've found a better path already
+        if (dist > scratch.distance[current]) {
+            continue;
+        }
+        
+        if (current != static_cast<uint32_t>(grid.start)) {
+            out.visit(current);
+        }
+        
+        int x = grid.xOf(current);
+        int y = grid.yOf(current);
+        
+        for (const auto& dir : ALL_DIRECTIONS) {
+            if (!grid.contains(x + dir.x, y + dir.y)) {
+                continue;
+            }
+            
+            uint32_t next = current + dir.y * grid.width + dir.x;
+            if (grid.isObstacle(next)) {
+                continue;
+            }
+            
+            uint32_t newDist = dist + moveCost(dir);
+            if (newDist < scratch.distance[next]) {
+                scratch.distance[next] = newDist;
+                scratch.parent[next] = current;
+                buckets[newDist & (BUCKETS - 1)].push_back(next);
+                pending++;
+                out.push(next);
+            }
+        }
+    }
+    
+    if (foundPath) {
+        reconstructPath(grid, scratch, out);
+    }
+}
+
+// Heuristics in move-cost units; both are admissible and consistent for their move sets
+inline uint32_t manhattanDistance(const GridMap& grid, uint32_t from, uint32_t to) {
+    uint32_t dx = std::abs(grid.xOf(from) - grid.xOf(to));
+    uint32_t dy = std::abs(grid.yOf(from) - grid.yOf(to));
+    return CARDINAL_COST * (dx + dy);
+}
+
+inline uint32_t octileDistance(const GridMap& grid, uint32_t from, uint32_t to) {
+    uint32_t dx = std::abs(grid.xOf(from) - grid.xOf(to));
+    uint32_t dy = std::abs(grid.yOf(from) - grid.yOf(to));
+    return CARDINAL_COST * std::max(dx, dy) + (DIAGONAL_COST - CARDINAL_COST) * std::min(dx, dy);
+}
+
+inline void pushOpen(std::vector<OpenEntry>& open, uint32_t g, uint32_t h, uint32_t cell) {
+    open.push_back({g + h, h, cell});
+    std::push_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+}
+
+// A* over 4 neighbours with the Manhattan heuristic, or over Dijkstra's 8 neighbours
+// with the octile heuristic. Equal f values expand the node nearest the goal first.
+template <typename Sink>
+void aStar(const GridMap& grid, SearchScratch& scratch, bool diagonal, Sink& out) {
+    scratch.reset(grid.cellCount());
+    scratch.resetDistances(grid.cellCount());
+    
+    const sf::Vector2i* directions = diagonal ? ALL_DIRECTIONS : CARDINAL_DIRECTIONS;
+    int directionCount = diagonal ? 8 : 4;
+    uint32_t goal = static_cast<uint32_t>(grid.end);
+    auto heuristic = [&](uint32_t cell) {
+        return diagonal ? octileDistance(grid, cell, goal) : manhattanDistance(grid, cell, goal);
+    };
+    
+    std::vector<OpenEntry>& open = scratch.open;
+    pushOpen(open, 0, heuristic(grid.start), grid.start);
+    out.push(grid.start);
+    scratch.distance[grid.start] = 0;
+    
+    bool foundPath = false;
+    
+    while (!open.empty() && out.active()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+        OpenEntry entry = open.back();
+        open.pop_back();
+        uint32_t current = entry.cell;
+        uint32_t g = entry.f - entry.h;
+        out.pop(current);
+        
+        if (current == goal) {
+            foundPath = true;
+            break;
+        }
+        
+        // Skip stale entries
+        if (g > scratch.distance[current]) {
+            continue;
+        }
+        
+        if (current != static_cast<uint32_t>(grid.start)) {
+            out.visit(current);
+        }
+        
+        int x = grid.xOf(current);
+        int y = grid.yOf(current);
+        
+        for (int d = 0; d < directionCount; d++) {
+            const sf::Vector2i& dir = directions[d];
+            if (!grid.contains(x + dir.x, y + dir.y)) {
+                continue;
+            }
+            
+            uint32_t next = current + dir.y * grid.width + dir.x;
+            if (grid.isObstacle(next)) {
+                continue;
+            }
+            
+            uint32_t newG = g + moveCost(dir);
+            if (newG < scratch.distance[next]) {
+                scratch.distance[next] = newG;
+                scratch.parent[next] = current;
+                pushOpen(open, newG, heuristic(next), next);
+                out.push(next);
+            }
+        }
+    }
+    
+    if (foundPath) {
+        reconstructPath(grid, scratch, out);
+    }
+}
+
+// Cells scanned while jumping are reported as reads; only jump points are expanded
+inline bool walkable(const GridMap& grid, int x, int y) {
+    return grid.contains(x, y) && !grid.isObstacle(grid.index(x, y));
+}
+
+// Walks from (x, y) in direction (dx, dy) until it reaches the goal or a cell with a
+// forced neighbour (a jump point), returning that cell, or UINT32_MAX at a wall.
+// Diagonal moves may pass between two obstacles, as in dijkstra().
+template <typename Sink>
+uint32_t jump(const GridMap& grid, int x, int y, int dx, int dy, Sink& out) {
+    while (true) {
+        x += dx;
+        y += dy;
+        if (!walkable(grid, x, y)) {
+            return UINT32_MAX;
+        }
+        
+        uint32_t cell = static_cast<uint32_t>(grid.index(x, y));
+        out.read(cell);
+        if (cell == static_cast<uint32_t>(grid.end)) {
+            return cell;
+        }
+        
+        if (dx != 0 && dy != 0) {
+            if ((!walkable(grid, x - dx, y) && walkable(grid, x - dx, y + dy)) ||
+                (!walkable(grid, x, y - dy) && walkable(grid, x + dx, y - dy))) {
+                return cell;
+            }
+            // A diagonal step is a jump point when a straight jump from it finds one
+            if (jump(grid, x, y, dx, 0, out) != UINT32_MAX || jump(grid, x, y, 0, dy, out) != UINT32_MAX) {
+                return cell;
+            }
+        } else if (dx != 0) {
+            if ((!walkable(grid, x, y + 1) && walkable(grid, x + dx, y + 1)) ||
+                (!walkable(grid, x, y - 1) && walkable(grid, x + dx, y - 1))) {
+                return cell;
+            }
+        } else {
+            if ((!walkable(grid, x + 1, y) && walkable(grid, x + 1, y + dy)) ||
+                (!walkable(grid, x - 1, y) && walkable(grid, x - 1, y + dy))) {
+                return cell;
+            }
+        }
+    }
+}
+
+// Jump Point Search: A* with the octile heuristic over Dijkstra's 8-connected moves,
+// expanding only the natural and forced neighbours of each jump point
+template <typename Sink>
+void jumpPointSearch(const GridMap& grid, SearchScratch& scratch, Sink& out) {
+    scratch.reset(grid.cellCount());
+    scratch.resetDistances(grid.cellCount());
+    
+    uint32_t start = static_cast<uint32_t>(grid.start);
+    uint32_t goal = static_cast<uint32_t>(grid.end);
+    std::vector<OpenEntry>& open = scratch.open;
+    pushOpen(open, 0, octileDistance(grid, start, goal), start);
+    out.push(start);
+    scratch.distance[start] = 0;
+    
+    bool foundPath = false;
+    
+    while (!open.empty() && out.active()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+        OpenEntry entry = open.back();
+        open.pop_back();
+        uint32_t current = entry.cell;
+        uint32_t g = entry.f - entry.h;
+        out.pop(current);
+        
+        if (current == goal) {
+            foundPath = true;
+            break;
+        }
+        
+        if (g > scratch.distance[current]) {
+            continue;
+        }
+        
+        if (current != start) {
+            out.visit(current);
+        }
+        
+        int x = grid.xOf(current);
+        int y = grid.yOf(current);
+        
+        // Prune to the directions that can lead somewhere the parent could not reach directly
+        sf::Vector2i candidates[8];
+        int count = 0;
+        if (current == start) {
+            for (const auto& dir : ALL_DIRECTIONS) {
+                candidates[count++] = dir;
+            }
+        } else {
+            uint32_t parent = scratch.parent[current];
+            int dx = (x > grid.xOf(parent)) - (x < grid.xOf(parent));
+            int dy = (y > grid.yOf(parent)) - (y < grid.yOf(parent));
+            
+            if (dx != 0 && dy != 0) {
+                candidates[count++] = sf::Vector2i(dx, 0);
+                candidates[count++] = sf::Vector2i(0, dy);
+                candidates[count++] = sf::Vector2i(dx, dy);
+                if (!walkable(grid, x - dx, y)) {
+                    candidates[count++] = sf::Vector2i(-dx, dy);
+                }
+                if (!walkable(grid, x, y - dy)) {
+                    candidates[count++] = sf::Vector2i(dx, -dy);
+                }
+            } else if (dx != 0) {
+                candidates[count++] = sf::Vector2i(dx, 0);
+                if (!walkable(grid, x, y + 1)) {
+                    candidates[count++] = sf::Vector2i(dx, 1);
+                }
+                if (!walkable(grid, x, y - 1)) {
+                    candidates[count++] = sf::Vector2i(dx, -1);
+                }
+            } else {
+                candidates[count++] = sf::Vector2i(0, dy);
+                if (!walkable(grid, x + 1, y)) {
+                    candidates[count++] = sf::Vector2i(1, dy);
+                }
+                if (!walkable(grid, x - 1, y)) {
+                    candidates[count++] = sf::Vector2i(-1, dy);
+                }
+            }
+        }
+        
+        for (int d = 0; d < count; d++) {
+            uint32_t next = jump(grid, x, y, candidates[d].x, candidates[d].y, out);
+            if (next == UINT32_MAX) {
+                continue;
+            }
+            
+            // Jumps follow a straight or diagonal line, so the octile distance is exact
+            uint32_t newG = g + octileDistance(grid, current, next);
+            if (newG < scratch.distance[next]) {
+                scratch.distance[next] = newG;
+                scratch.parent[next] = current;
+                pushOpen(open, newG, octileDistance(grid, next, goal), next);
+                out.push(next);
+            }
+        }
+    }
+    
+    if (foundPath) {
+        // Parents link jump points; fill in the cells between them so the shared
+        // reconstruction can walk the path one step at a time
+        uint32_t current = goal;
+        while (current != start) {
+            uint32_t parent = scratch.parent[current];
+            int dx = (grid.xOf(current) > grid.xOf(parent)) - (grid.xOf(current) < grid.xOf(parent));
+            int dy = (grid.yOf(current) > grid.yOf(parent)) - (grid.yOf(current) < grid.yOf(parent));
+            uint32_t step = static_cast<uint32_t>(dy * grid.width + dx);
+            for (uint32_t cell = parent; cell != current; cell += step) {
+                scratch.parent[cell + step] = cell;
+            }
+            current = parent;
+        }
+        reconstructPath(grid, scratch, out);
+    }
+}
+
+// Dispatch helpers shared by the visualizer and the headless benchmark
+template <typename Sink>
+void runSort(AlgorithmType algorithm, std::vector<int>& a, Sink& out) {
+    int last = static_cast<int>(a.size()) - 1;
+    
+    switch (algorithm) {
+        case AlgorithmType::BUBBLE_SORT:
+            bubbleSort(a, out);
+            break;
+        case AlgorithmType::INSERTION_SORT:
+            insertionSort(a, out);
+            break;
+        case AlgorithmType::SELECTION_SORT:
+            selectionSort(a, out);
+            break;
+        case AlgorithmType::QUICK_SORT:
+            quickSort(a, 0, last, out);
+            break;
+        case AlgorithmType::PARALLEL_QUICK_SORT:
+            parallelQuickSort(a, out);
+            break;
+        case AlgorithmType::MERGE_SORT:
+            mergeSort(a, out);
+            break;
+        case AlgorithmType::BOTTOM_UP_MERGE_SORT:
+            bottomUpMergeSort(a, out);
+            break;
+        case AlgorithmType::PARALLEL_MERGE_SORT:
+            parallelMergeSort(a, out);
+            break;
+        case AlgorithmType::COUNTING_SORT:
+            countingSort(a, out);
+            break;
+        case AlgorithmType::RADIX_SORT:
+            radixSort(a, out);
+            break;
+        case AlgorithmType::BITONIC_SORT:
+            bitonicSort(a, out);
+            break;
+        default:
+            break;
+    }
+}
+
+template <typename Sink>
+void runPathfinding(AlgorithmType algorithm, const GridMap& grid, SearchScratch& scratch, Sink& out) {
+    switch (algorithm) {
+        case AlgorithmType::BFS:
+            bfs(grid, scratch, out);
+            break;
+        case AlgorithmType::BIT_BFS:
+            bitBfs(grid, scratch, out);
+            break;
+        case AlgorithmType::BIDIRECTIONAL_BFS:
+            bidirectionalBfs(grid, scratch, out);
+            break;
+        case AlgorithmType::PARALLEL_BFS:
+            parallelBfs(grid, scratch, out);
+            break;
+        case AlgorithmType::DFS:
+            dfs(grid, scratch, out);
+            break;
+        case AlgorithmType::DIJKSTRA:
+            dijkstra(grid, scratch, out);
+            break;
+        case AlgorithmType::DIAL_DIJKSTRA:
+            dialDijkstra(grid, scratch, out);
+            break;
+        case AlgorithmType::ASTAR:
+            aStar(grid, scratch, false, out);
+            break;
+        case AlgorithmType::ASTAR_OCTILE:
+            aStar(grid, scratch, true, out);
+            break;
+        case AlgorithmType::JUMP_POINT_SEARCH:
+            jumpPointSearch(grid, scratch, out);
+            break;
+        default:
+            break;
+    }
+}
+
+// Tint for steps recorded by worker thread `thread` (1-based) of a parallel algorithm
+inline sf::Color threadColor(size_t thread) {
+    static const sf::Color PALETTE[] = {
+        sf::Color(100, 220, 140), sf::Color(240, 200, 80), sf::Color(200, 130, 250),
+        sf::Color(90, 220, 230), sf::Color(250, 150, 90), sf::Color(160, 200, 90),
+        sf::Color(240, 120, 190), sf::Color(150, 150, 250)
+    };
+    return PALETTE[(thread - 1) % 8];
+}
+
+// Persistent bar chart renderer: one quad per element kept in a vertex buffer,
+// only the bars touched since the last frame are rewritten and uploaded.
+// Arrays much wider than the viewport switch to level of detail: each pixel column
+// becomes one bar showing the mean of its elements, overlaid with their min-max range.
+// Columns span whole blocks of elements, and a segment tree over the blocks' min/max/sum
+// keeps every column current, so a frame costs O(screen width) plus the changed blocks.
+class BarRenderer {
+private:
+    static const size_t LOD_FACTOR = 2;          // elements per pixel column before switching
+    static const size_t BLOCKS_PER_COLUMN = 64;
+    
+    struct Aggregate {
+        int min;
+        int max;
+        int64_t sum;
+    };
+    
+    std::vector<sf::Vertex> vertices;
+    sf::VertexBuffer buffer;
+    bool useBuffer;
+    
+    // Bars are elements, or pixel columns in level-of-detail mode
+    std::vector<size_t> dirty;
+    std::vector<char> isDirty;
+    bool fullUpload;
+    
+    // Bars highlighted this frame, and last frame's highlights to restore
+    std::vector<char> isHighlighted;
+    std::vector<size_t> highlighted;
+    
+    // Worker thread (1-based) that last wrote each bar in a parallel sort, 0 if none
+    std::vector<uint8_t> owner;
+    bool hasOwners;
+    
+    // Level of detail state; leaves of the tree start at leafBase, a power of two
+    bool lod;
+    size_t elementCount;
+    size_t barCount;
+    size_t blockSize;
+    size_t blockCount;
+    size_t leafBase;
+    std::vector<Aggregate> tree;
+    std::vector<size_t> dirtyBlocks;
+    std::vector<char> isBlockDirty;
+    
+    sf::FloatRect bounds; // left/width span the bars, top + height is the baseline
+    float barWidth;
+    float barGap;
+    float heightScale;
+    sf::Color barColor;
+    sf::Color highlightColor;
+    
+    size_t verticesPerBar() const { return lod ? 8 : 4; }
+    
+    size_t barOf(size_t i) const {
+        if (!lod) {
+            return i;
+        }
+        // Column c spans blocks [c * blockCount / barCount, (c + 1) * blockCount / barCount)
+        return ((i / blockSize + 1) * barCount - 1) / blockCount;
+    }
+    
+    static Aggregate combine(const Aggregate& a, const Aggregate& b) {
+        return {std::min(a.min, b.min), std::max(a.max, b.max), a.sum + b.sum};
+    }
+    
+    void writeQuad(sf::Vertex* quad, float x, float top, float bottom, const sf::Color& color) {
+        float right = x + barWidth - barGap;
+        quad[0] = sf::Vertex(sf::Vector2f(x, top), color);
+        quad[1] = sf::Vertex(sf::Vector2f(right, top), color);
+        quad[2] = sf::Vertex(sf::Vector2f(right, bottom), color);
+        quad[3] = sf::Vertex(sf::Vector2f(x, bottom), color);
+    }
+    
+    void writeBar(size_t bar, const std::vector<int>& values) {
+        float x = bounds.left + bar * barWidth;
+        float bottom = bounds.top + bounds.height;
+        sf::Color color = isHighlighted[bar] ? highlightColor : owner[bar] ? threadColor(owner[bar]) : barColor;
+        sf::Vertex* quad = &vertices[bar * verticesPerBar()];
+        
+        if (!lod) {
+            writeQuad(quad, x, bottom - values[bar] * heightScale, bottom, color);
+            return;
+        }
+        
+        size_t firstBlock = bar * blockCount / barCount;
+        size_t lastBlock = (bar + 1) * blockCount / barCount;
+        Aggregate column = queryBlocks(firstBlock, lastBlock);
+        size_t count = std::min(elementCount, lastBlock * blockSize) - firstBlock * blockSize;
+        double mean = static_cast<double>(column.sum) / count;
+        
+        sf::Color range = color;
+        range.a = 90;
+        writeQuad(quad, x, bottom - static_cast<float>(mean * heightScale), bottom, color);
+        writeQuad(quad + 4, x, bottom - column.max * heightScale, bottom - column.min * heightScale, range);
+    }
+    
+    Aggregate queryBlocks(size_t first, size_t last) const {
+        Aggregate result{INT_MAX, INT_MIN, 0};
+        for (size_t l = first + leafBase, r = last + leafBase; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) {
+                result = combine(result, tree[l++]);
+            }
+            if (r & 1) {
+                result = combine(result, tree[--r]);
+            }
+        }
+        return result;
+    }
+    
+    void computeBlock(size_t block, const std::vector<int>& values) {
+        Aggregate leaf{INT_MAX, INT_MIN, 0};
+        size_t end = std::min(elementCount, (block + 1) * blockSize);
+        for (size_t i = block * blockSize; i < end; i++) {
+            leaf.min = std::min(leaf.min, values[i]);
+            leaf.max = std::max(leaf.max, values[i]);
+            leaf.sum += values[i];
+        }
+        tree[leafBase + block] = leaf;
+    }
+    
+    // Recomputes the changed blocks and their ancestors, and marks their columns dirty
+    void refreshBlocks(const std::vector<int>& values) {
+        for (size_t block : dirtyBlocks) {
+            computeBlock(block, values);
+        }
+        
+        // Past a few changed blocks per path it is cheaper to rebuild every inner node
+        if (dirtyBlocks.size() * 16 > blockCount) {
+            for (size_t node = leafBase - 1; node > 0; node--) {
+                tree[node] = combine(tree[2 * node], tree[2 * node + 1]);
+            }
+        } else {
+            for (size_t block : dirtyBlocks) {
+                for (size_t node = (leafBase + block) / 2; node > 0; node /= 2) {
+                    tree[node] = combine(tree[2 * node], tree[2 * node + 1]);
+                }
+            }
+        }
+        
+        for (size_t block : dirtyBlocks) {
+            isBlockDirty[block] = 0;
+            markBarDirty(((block + 1) * barCount - 1) / blockCount);
+        }
+        dirtyBlocks.clear();
+    }
+    
+    void markBarDirty(size_t bar) {
+        if (bar < isDirty.size() && !isDirty[bar]) {
+            isDirty[bar] = 1;
+            dirty.push_back(bar);
+        }
+    }
+    
+    void upload() {
+        if (!useBuffer) {
+            return;
+        }
+        
+        // Many scattered updates cost more than one full upload
+        if (fullUpload || dirty.size() * 8 > isDirty.size()) {
+            buffer.update(vertices.data());
+            return;
+        }
+        
+        std::sort(dirty.begin(), dirty.end());
+        
+        size_t stride = verticesPerBar();
+        size_t runStart = 0;
+        for (size_t k = 1; k <= dirty.size(); k++) {
+            if (k == dirty.size() || dirty[k] != dirty[k - 1] + 1) {
+                size_t first = dirty[runStart];
+                size_t count = dirty[k - 1] - first + 1;
+                buffer.update(&vertices[first * stride], count * stride, static_cast<unsigned int>(first * stride));
+                runStart = k;
+            }
+        }
+    }
+    
+public:
+    BarRenderer() :
+        buffer(sf::Quads, sf::VertexBuffer::Stream),
+        useBuffer(false),
+        fullUpload(true),
+        hasOwners(false),
+        lod(false),
+        elementCount(0),
+        barCount(0),
+        blockSize(1),
+        blockCount(0),
+        leafBase(1),
+        barWidth(0),
+        barGap(0),
+        heightScale(0),
+        barColor(100, 180, 255),
+        highlightColor(255, 90, 90)
+    {
+    }
+    
+    // Rebuilds every bar; call when the array is replaced or resized
+    void reset(const std::vector<int>& values, int maxValue, const sf::FloatRect& area) {
+        bounds = area;
+        elementCount = values.size();
+        size_t columns = std::max<size_t>(1, static_cast<size_t>(bounds.width));
+        lod = elementCount > columns * LOD_FACTOR;
+        barCount = lod ? columns : elementCount;
+        barWidth = barCount == 0 ? 0 : bounds.width / barCount;
+        barGap = barWidth > 2 ? 1 : 0;
+        heightScale = maxValue > 0 ? bounds.height / maxValue : 0;
+        
+        if (lod) {
+            blockSize = std::max<size_t>(1, elementCount / (columns * BLOCKS_PER_COLUMN));
+            blockCount = (elementCount + blockSize - 1) / blockSize;
+            leafBase = 1;
+            while (leafBase < blockCount) {
+                leafBase *= 2;
+            }
+            tree.assign(2 * leafBase, Aggregate{INT_MAX, INT_MIN, 0});
+            isBlockDirty.assign(blockCount, 0);
+            dirtyBlocks.clear();
+            for (size_t block = 0; block < blockCount; block++) {
+                computeBlock(block, values);
+            }
+            for (size_t node = leafBase - 1; node > 0; node--) {
+                tree[node] = combine(tree[2 * node], tree[2 * node + 1]);
+            }
+        } else {
+            tree.clear();
+            isBlockDirty.clear();
+            dirtyBlocks.clear();
+        }
+        
+        vertices.resize(barCount * verticesPerBar());
+        isHighlighted.assign(barCount, 0);
+        highlighted.clear();
+        owner.assign(barCount, 0);
+        hasOwners = false;
+        for (size_t bar = 0; bar < barCount; bar++) {
+            writeBar(bar, values);
+        }
+        
+        useBuffer = sf::VertexBuffer::isAvailable() && buffer.create(vertices.size());
+        
+        dirty.clear();
+        isDirty.assign(barCount, 0);
+        fullUpload = true;
+    }
+    
+    // Marks element i changed
+    void markDirty(size_t i) {
+        if (!lod) {
+            markBarDirty(i);
+            return;
+        }
+        size_t block = i / blockSize;
+        if (block < blockCount && !isBlockDirty[block]) {
+            isBlockDirty[block] = 1;
+            dirtyBlocks.push_back(block);
+        }
+    }
+    
+    // Draws element i's bar in the highlight colour for the next frame only
+    void highlight(size_t i) {
+        size_t bar = barOf(i);
+        if (bar < isHighlighted.size()) {
+            isHighlighted[bar] = 1;
+            markBarDirty(bar);
+        }
+    }
+    
+    // Tints element i's bar with the colour of the worker thread that wrote it
+    void setOwner(size_t i, size_t thread) {
+        size_t bar = barOf(i);
+        if (bar < owner.size() && owner[bar] != thread) {
+            owner[bar] = static_cast<uint8_t>(std::min<size_t>(thread, 255));
+            hasOwners = true;
+            markBarDirty(bar);
+        }
+    }
+    
+    void clearOwners() {
+        if (!hasOwners) {
+            return;
+        }
+        std::fill(owner.begin(), owner.end(), 0);
+        hasOwners = false;
+        fullUpload = true;
+        for (size_t bar = 0; bar < owner.size(); bar++) {
+            markBarDirty(bar);
+        }
+    }
+    
+    // Rewrites the touched bars from values, uploads them and issues a single draw call
+    // Returns the number of draw calls issued
+    unsigned draw(sf::RenderTarget& target, const std::vector<int>& values) {
+        for (size_t bar : highlighted) {
+            markBarDirty(bar);
+        }
+        highlighted.clear();
+        
+        if (lod) {
+            refreshBlocks(values);
+        }
+        
+        for (size_t bar : dirty) {
+            writeBar(bar, values);
+        }
+        
+        upload();
+        
+        for (size_t bar : dirty) {
+            isDirty[bar] = 0;
+            if (isHighlighted[bar]) {
+                isHighlighted[bar] = 0;
+                highlighted.push_back(bar);
+            }
+        }
+        dirty.clear();
+        fullUpload = false;
+        
+        if (vertices.empty()) {
+            return 0;
+        }
+        
+        if (useBuffer) {
+            target.draw(buffer);
+        } else {
+            target.draw(vertices.data(), vertices.size(), sf::Quads);
+        }
+        return 1;
+    }
+};
+
+// Texture-backed grid renderer: one texel per cell, scaled up on draw.
+// Cell colours live in a CPU pixel buffer and only dirty tiles are uploaded.
+class GridRenderer {
+private:
+    static const int TILE = 64;
+    
+    int width;
+    int height;
+    int tilesPerRow;
+    std::vector<sf::Uint8> pixels; // RGBA, row-major, one texel per cell
+    std::vector<sf::Uint8> staging;
+    std::vector<int> dirtyTiles;
+    std::vector<char> isTileDirty;
+    bool textureReady;
+    
+    sf::Texture texture;
+    sf::Sprite sprite;
+    sf::VertexArray gridLines;
+    int start;
+    int end;
+    
+    static sf::Color cellColor(int state) {
+        switch (state) {
+            case 1: return sf::Color(100, 100, 100); // Obstacle
+            case 2: return sf::Color(100, 180, 255); // Visited
+            case 3: return sf::Color(255, 255, 0);   // Path
+            case 4: return sf::Color(60, 100, 140);  // Frontier
+            default: return sf::Color(40, 40, 40);   // Empty
+        }
+    }
+    
+    void writeTexel(int cell, const sf::Color& color) {
+        sf::Uint8* texel = &pixels[static_cast<size_t>(cell) * 4];
+        texel[0] = color.r;
+        texel[1] = color.g;
+        texel[2] = color.b;
+        texel[3] = color.a;
+    }
+    
+    void uploadTile(int tile) {
+        int tx = (tile % tilesPerRow) * TILE;
+        int ty = (tile / tilesPerRow) * TILE;
+        int w = std::min(TILE, width - tx);
+        int h = std::min(TILE, height - ty);
+        
+        // sf::Texture::update expects the sub-rectangle to be tightly packed
+        for (int row = 0; row < h; row++) {
+            const sf::Uint8* src = &pixels[(static_cast<size_t>(ty + row) * width + tx) * 4];
+            std::copy(src, src + w * 4, &staging[static_cast<size_t>(row) * w * 4]);
+        }
+        
+        texture.update(staging.data(), w, h, tx, ty);
+    }
+    
+public:
+    GridRenderer() :
+        width(0),
+        height(0),
+        tilesPerRow(0),
+        textureReady(false),
+        gridLines(sf::Lines),
+        start(-1),
+        end(-1)
+    {
+    }
+    
+    // Rebuilds the pixel buffer from the grid and uploads it in full
+    void reset(const GridMap& grid, const sf::FloatRect& area) {
+        width = grid.width;
+        height = grid.height;
+        start = grid.start;
+        end = grid.end;
+        tilesPerRow = (width + TILE - 1) / TILE;
+        
+        pixels.resize(grid.cellCount() * 4);
+        staging.resize(TILE * TILE * 4);
+        for (size_t cell = 0; cell < grid.cellCount(); cell++) {
+            writeTexel(static_cast<int>(cell), cellColor(grid.cells[cell]));
+        }
+        if (!grid.cells.empty()) {
+            writeTexel(start, sf::Color::Green);
+            writeTexel(end, sf::Color::Red);
+        }
+        
+        dirtyTiles.clear();
+        isTileDirty.assign(static_cast<size_t>(tilesPerRow) * ((height + TILE - 1) / TILE), 0);
+        
+        unsigned int maxSize = sf::Texture::getMaximumSize();
+        textureReady = width > 0 && height > 0 &&
+                       static_cast<unsigned int>(width) <= maxSize && static_cast<unsigned int>(height) <= maxSize &&
+                       texture.create(width, height);
+        if (!textureReady) {
+            std::cerr << "Grid of " << width << "x" << height << " does not fit in a texture!" << std::endl;
+            return;
+        }
+        texture.update(pixels.data());
+        
+        float cellSize = std::min(area.width / width, area.height / height);
+        float offsetX = area.left + (area.width - cellSize * width) / 2;
+        float offsetY = area.top + (area.height - cellSize * height) / 2;
+        
+        sprite.setTexture(texture, true);
+        sprite.setPosition(offsetX, offsetY);
+        sprite.setScale(cellSize, cellSize);
+        
+        // Cell borders only make sense while cells are a few pixels wide
+        gridLines.clear();
+        if (cellSize >= 4) {
+            sf::Color lineColor(30, 30, 30);
+            for (int i = 0; i <= width; i++) {
+                float x = offsetX + i * cellSize;
+                gridLines.append(sf::Vertex(sf::Vector2f(x, offsetY), lineColor));
+                gridLines.append(sf::Vertex(sf::Vector2f(x, offsetY + cellSize * height), lineColor));
+            }
+            for (int i = 0; i <= height; i++) {
+                float y = offsetY + i * cellSize;
+                gridLines.append(sf::Vertex(sf::Vector2f(offsetX, y), lineColor));
+                gridLines.append(sf::Vertex(sf::Vector2f(offsetX + cellSize * width, y), lineColor));
+            }
+        }
+    }
+    
+    // Visited cells take the colour of the worker thread that reached them, if any
+    void setCell(int cell, int state, size_t thread = 0) {
+        if (cell == start || cell == end) {
+            return;
+        }
+        
+        writeTexel(cell, state == 2 && thread ? threadColor(thread) : cellColor(state));
+        
+        int tile = (cell / width / TILE) * tilesPerRow + (cell % width) / TILE;
+        if (!isTileDirty[tile]) {
+            isTileDirty[tile] = 1;
+            dirtyTiles.push_back(tile);
+        }
+    }
+    
+    // Returns the number of draw calls issued
+    unsigned draw(sf::RenderTarget& target) {
+        if (!textureReady) {
+            return 0;
+        }
+        
+        for (int tile : dirtyTiles) {
+            uploadTile(tile);
+            isTileDirty[tile] = 0;
+        }
+        dirtyTiles.clear();
+        
+        target.draw(sprite);
+        if (gridLines.getVertexCount() > 0) {
+            target.draw(gridLines);
+            return 2;
+        }
+        return 1;
+    }
+};
+
+// Frame profiler: scoped timers around the phases of the window loop. Keeps the last
+// WINDOW frames for the overlay and, while recording, a timeline of every phase that
+// exportTrace() writes as Chrome trace_event JSON for chrome://tracing or Perfetto.
+class FrameProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    enum Phase { EVENTS, DRAIN, PLAYBACK, DRAW, PRESENT, SLEEP, PHASE_COUNT };
+    static const size_t WINDOW = 240;            // frames in the rolling statistics
+    static const size_t MAX_EVENTS = 1u << 22;   // timeline events kept for export
+    
+    // Times the enclosing block as one phase of the current frame
+    class Scope {
+    private:
+        FrameProfiler& profiler;
+        Phase phase;
+        Clock::time_point begin;
+        
+    public:
+        Scope(FrameProfiler& p, Phase ph) : profiler(p), phase(ph), begin(Clock::now()) {}
+        ~Scope() { profiler.add(phase, begin, Clock::now()); }
+    };
+    
+private:
+    struct Frame {
+        double millis = 0;
+        double phases[PHASE_COUNT] = {};
+        unsigned drawCalls = 0;
+        size_t steps = 0;
+    };
+    
+    // Complete ('X') events carry a duration, counter ('C') events a value
+    struct Event {
+        const char* name;
+        char type;
+        int thread;
+        double start; // microseconds since the profiler was created
+        double value;
+    };
+    
+    Clock::time_point origin;
+    Clock::time_point frameStart;
+    Frame current;
+    std::vector<Frame> frames; // ring of the last WINDOW completed frames
+    size_t frameCount;
+    bool started;
+    bool recording;
+    std::vector<Event> events;
+    
+    // Step indices with the time they were drained from the worker; see stepsApplied()
+    std::deque<std::pair<uint64_t, Clock::time_point>> arrivals;
+    double latencyMillis;
+    
+    double micros(Clock::time_point time) const {
+        return std::chrono::duration<double, std::micro>(time - origin).count();
+    }
+    
+    void record(const char* name, char type, int thread, double start, double value) {
+        if (recording && events.size() < MAX_EVENTS) {
+            events.push_back(Event{name, type, thread, start, value});
+        }
+    }
+    
+    static const char* phaseName(Phase phase) {
+        static const char* names[PHASE_COUNT] = {"Events", "Drain", "Playback", "Draw", "Present", "Sleep"};
+        return names[phase];
+    }
+    
+public:
+    FrameProfiler() :
+        origin(Clock::now()),
+        frameStart(origin),
+        frames(WINDOW),
+        frameCount(0),
+        started(false),
+        recording(false),
+        latencyMillis(0)
+    {
+    }
+    
+    void setRecording(bool on) { recording = on; }
+    
+    // Closes the previous frame and starts timing the next one
+    void beginFrame() {
+        Clock::time_point now = Clock::now();
+        if (started) {
+            current.millis = std::chrono::duration<double, std::milli>(now - frameStart).count();
+            record("Frame", 'X', 1, micros(frameStart), current.millis * 1000);
+            record("Steps", 'C', 1, micros(frameStart), static_cast<double>(current.steps));
+            frames[frameCount % WINDOW] = current;
+            frameCount++;
+        }
+        current = Frame();
+        frameStart = now;
+        started = true;
+    }
+    
+    void add(Phase phase, Clock::time_point begin, Clock::time_point end) {
+        double millis = std::chrono::duration<double, std::milli>(end - begin).count();
+        current.phases[phase] += millis;
+        record(phaseName(phase), 'X', 1, micros(begin), millis * 1000);
+    }
+    
+    void countDrawCalls(unsigned count) { current.drawCalls += count; }
+    void countSteps(size_t count) { current.steps += count; }
+    
+    // A span on the timeline of worker thread `thread` (from 1), e.g. one algorithm run
+    void span(const char* name, int thread, Clock::time_point begin, double millis) {
+        record(name, 'X', thread + 1, micros(begin), millis * 1000);
+    }
+    
+    // Step latency: how long the most recently applied step waited between leaving the
+    // worker's queue and reaching the screen. Indices count steps since the run started.
+    void stepsArrived(uint64_t end) {
+        if (arrivals.empty() || arrivals.back().first < end) {
+            arrivals.emplace_back(end, Clock::now());
+        }
+    }
+    
+    void stepsApplied(uint64_t end) {
+        while (!arrivals.empty() && arrivals.front().first <= end) {
+            latencyMillis = std::chrono::duration<double, std::milli>(Clock::now() - arrivals.front().second).count();
+            arrivals.pop_front();
+        }
+    }
+    
+    void resetSteps() {
+        arrivals.clear();
+        latencyMillis = 0;
+    }
+    
+    size_t sampleCount() const { return std::min(frameCount, WINDOW); }
+    
+    // Frame time at quantile q (0-1) of the rolling window
+    double percentile(double q) const {
+        std::vector<double> millis;
+        for (size_t i = 0; i < sampleCount(); i++) {
+            millis.push_back(frames[i].millis);
+        }
+        if (millis.empty()) {
+            return 0;
+        }
+        size_t k = std::min(millis.size() - 1, static_cast<size_t>(q * millis.size()));
+        std::nth_element(millis.begin(), millis.begin() + k, millis.end());
+        return millis[k];
+    }
+    
+    double phaseMean(Phase phase) const {
+        double sum = 0;
+        for (size_t i = 0; i < sampleCount(); i++) {
+            sum += frames[i].phases[phase];
+        }
+        return sampleCount() ? sum / sampleCount() : 0;
+    }
+    
+    // Counts of the rolling window's frame times in buckets of bucketMillis; the last bucket takes the rest
+    std::vector<size_t> histogram(size_t buckets, double bucketMillis) const {
+        std::vector<size_t> counts(buckets, 0);
+        for (size_t i = 0; i < sampleCount(); i++) {
+            counts[std::min(buckets - 1, static_cast<size_t>(frames[i].millis / bucketMillis))]++;
+        }
+        return counts;
+    }
+    
+    const Frame& lastFrame() const { return frames[(frameCount + WINDOW - 1) % WINDOW]; }
+    double stepLatency() const { return latencyMillis; }
+    
+    std::string summary() const {
+        auto ms = [](double value) {
+            return std::to_string(static_cast<int>(value)) + "." + std::to_string(static_cast<int>(value * 10) % 10);
+        };
+        std::string text = "Frame p50 " + ms(percentile(0.5)) + " ms  p99 " + ms(percentile(0.99)) + " ms  (" +
+                           std::to_string(sampleCount()) + " frames)\n";
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            text += std::string(phase ? "  " : "") + phaseName(static_cast<Phase>(phase)) + " " +
+                    ms(phaseMean(static_cast<Phase>(phase)));
+        }
+        return text + " ms\nDraw calls " + std::to_string(lastFrame().drawCalls) + "  Steps " +
+               std::to_string(lastFrame().steps) + "  Step latency " + ms(latencyMillis) + " ms";
+    }
+    
+    bool exportTrace(const std::string& path) const {
+        FILE* file = std::fopen(path.c_str(), "w");
+        if (!file) {
+            std::cerr << "Cannot create " << path << std::endl;
+            return false;
+        }
+        
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Window\"}}");
+        int workers = 0;
+        for (const Event& event : events) {
+            workers = std::max(workers, event.thread - 1);
+        }
+        for (int worker = 1; worker <= workers; worker++) {
+            std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Worker %d\"}}",
+                         worker + 1, worker);
+        }
+        for (const Event& event : events) {
+            if (event.type == 'X') {
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                             event.name, event.thread, event.start, event.value);
+            } else {
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%.0f}}",
+                             event.name, event.thread, event.start, event.value);
+            }
+        }
+        std::fprintf(file, "\n]}\n");
+        
+        bool written = std::ferror(file) == 0;
+        written = std::fclose(file) == 0 && written;
+        if (!written) {
+            std::cerr << "Failed to write " << path << std::endl;
+        }
+        return written;
+    }
+};
+
+// Cache simulator: an L1 and an L2 cache, both set-associative with LRU replacement,
+// fed with the memory accesses the replayed steps imply (see stepAccesses)
+struct CacheConfig {
+    size_t lineBytes = 64;
+    size_t l1Bytes = 32 * 1024;
+    size_t l1Ways = 8;
+    size_t l2Bytes = 1024 * 1024;
+    size_t l2Ways = 16;
+};
+
+// Parses "L1_KB:WAYS,L2_KB:WAYS[,LINE_BYTES]", e.g. "32:8,1024:16,64"
+inline bool parseCacheConfig(const std::string& spec, CacheConfig& config) {
+    size_t l1 = 0, l1Ways = 0, l2 = 0, l2Ways = 0, line = 64;
+    int fields = std::sscanf(spec.c_str(), "%zu:%zu,%zu:%zu,%zu", &l1, &l1Ways, &l2, &l2Ways, &line);
+    if (fields < 4 || line == 0 || (line & (line - 1)) != 0 || l1Ways == 0 || l2Ways == 0 ||
+        l1 * 1024 < line * l1Ways || l2 * 1024 < line * l2Ways) {
+        std::cerr << "Invalid cache configuration: " << spec << std::endl;
+        return false;
+    }
+    config = CacheConfig{line, l1 * 1024, l1Ways, l2 * 1024, l2Ways};
+    return true;
+}
+
+class CacheLevel {
+private:
+    size_t ways;
+    size_t sets;
+    std::vector<uint64_t> tags; // line number + 1 per way, 0 = empty
+    std::vector<uint64_t> used; // time of each way's last access
+    uint64_t clock;
+    
+public:
+    CacheLevel() : ways(1), sets(1), clock(0) {}
+    
+    void configure(size_t bytes, size_t lineBytes, size_t wayCount) {
+        ways = std::max<size_t>(1, wayCount);
+        sets = std::max<size_t>(1, bytes / lineBytes / ways);
+        tags.assign(sets * ways, 0);
+        used.assign(sets * ways, 0);
+        clock = 0;
+    }
+    
+    void clear() {
+        std::fill(tags.begin(), tags.end(), 0);
+        std::fill(used.begin(), used.end(), 0);
+        clock = 0;
+    }
+    
+    // Looks up a line and loads it on a miss, evicting the least recently used way
+    bool access(uint64_t line) {
+        size_t base = (line % sets) * ways;
+        size_t victim = base;
+        clock++;
+        for (size_t way = base; way < base + ways; way++) {
+            if (tags[way] == line + 1) {
+                used[way] = clock;
+                return true;
+            }
+            if (used[way] < used[victim]) {
+                victim = way;
+            }
+        }
+        tags[victim] = line + 1;
+        used[victim] = clock;
+        return false;
+    }
+};
+
+struct CacheCounters {
+    uint64_t accesses = 0;
+    uint64_t l1Misses = 0;
+    uint64_t l2Misses = 0;
+    
+    std::string summary(size_t elements) const {
+        char text[192];
+        std::snprintf(text, sizeof(text),
+                      "Accesses %llu  L1 misses %llu (%.1f%%)  L2 misses %llu (%.1f%%)  L1 misses/element %.2f",
+                      static_cast<unsigned long long>(accesses), static_cast<unsigned long long>(l1Misses),
+                      accesses ? 100.0 * l1Misses / accesses : 0.0, static_cast<unsigned long long>(l2Misses),
+                      accesses ? 100.0 * l2Misses / accesses : 0.0,
+                      elements ? static_cast<double>(l1Misses) / elements : 0.0);
+        return text;
+    }
+};
+
+class CacheSimulator {
+private:
+    unsigned lineShift;
+    CacheLevel l1;
+    CacheLevel l2;
+    
+public:
+    CacheCounters counters;
+    
+    CacheSimulator() : lineShift(6) {}
+    
+    void configure(const CacheConfig& config) {
+        lineShift = 0;
+        while ((size_t(1) << lineShift) < config.lineBytes) {
+            lineShift++;
+        }
+        l1.configure(config.l1Bytes, config.lineBytes, config.l1Ways);
+        l2.configure(config.l2Bytes, config.lineBytes, config.l2Ways);
+        counters = CacheCounters();
+    }
+    
+    void reset() {
+        l1.clear();
+        l2.clear();
+        counters = CacheCounters();
+    }
+    
+    // Simulates one access; true when it missed L1
+    bool access(uint64_t address) {
+        uint64_t line = address >> lineShift;
+        counters.accesses++;
+        if (l1.access(line)) {
+            return false;
+        }
+        counters.l1Misses++;
+        if (!l2.access(line)) {
+            counters.l2Misses++;
+        }
+        return true;
+    }
+};
+
+// Memory layout assumed for the steps: the array as 4-byte ints; for grids the cell
+// bytes, the visited bitset and the 4-byte parent array, each in its own region.
+// Steps name logical elements, so a temporary buffer (e.g. merge sort's) shows up as
+// the reads of the elements copied into it. Calls access(address, element) for every
+// memory access of the step, attributed to the element the step is about.
+const uint64_t CACHE_REGION = 1ull << 40;
+
+template <typename Access>
+void stepAccesses(const StepEvent& step, const GridMap* grid, Access access) {
+    uint64_t index = step.index();
+    if (!grid) {
+        switch (step.type()) {
+            case StepType::SWAP:
+                // Both elements are read and written back, as OpCounters counts them
+                access(index * 4, index);
+                access(static_cast<uint64_t>(step.operand) * 4, step.operand);
+                access(index * 4, index);
+                access(static_cast<uint64_t>(step.operand) * 4, step.operand);
+                break;
+            case StepType::COMPARE:
+                access(index * 4, index);
+                access(static_cast<uint64_t>(step.operand) * 4, step.operand);
+                break;
+            case StepType::WRITE:
+            case StepType::READ:
+                access(index * 4, index);
+                break;
+            default:
+                break;
+        }
+        return;
+    }
+    
+    const uint64_t cells = 0;
+    const uint64_t visited = CACHE_REGION;
+    const uint64_t parent = 2 * CACHE_REGION;
+    switch (step.type()) {
+        case StepType::VISIT: {
+            // Expanding a cell checks each neighbour's cell and visited bit
+            int x = grid->xOf(static_cast<uint32_t>(index));
+            int y = grid->yOf(static_cast<uint32_t>(index));
+            const int dx[4] = {1, -1, 0, 0};
+            const int dy[4] = {0, 0, 1, -1};
+            for (int d = 0; d < 4; d++) {
+                if (grid->contains(x + dx[d], y + dy[d])) {
+                    uint64_t neighbor = grid->index(x + dx[d], y + dy[d]);
+                    access(cells + neighbor, index);
+                    access(visited + neighbor / 8, index);
+                }
+            }
+            break;
+        }
+        case StepType::PUSH:
+            access(visited + index / 8, index);
+            access(parent + index * 4, index);
+            break;
+        case StepType::READ:
+            access(cells + index, index);
+            break;
+        case StepType::PATH:
+            access(parent + index * 4, index);
+            break;
+        default:
+            break;
+    }
+}
+
+// Access and L1 miss counts drawn as a translucent overlay: one band per pixel column of
+// the bar chart, or one square per block of grid cells (at most 128 x 128 blocks),
+// coloured from green (all hits) to red (a quarter or more of the accesses missing L1)
+class HeatmapOverlay {
+private:
+    size_t elementCount;
+    int gridWidth; // 0 for arrays
+    int blockSize;
+    int columns;
+    int rows;
+    sf::FloatRect bounds; // where the bars or cells are drawn
+    float blockWidth;
+    float blockHeight;
+    std::vector<uint32_t> accesses;
+    std::vector<uint32_t> misses;
+    std::vector<sf::Vertex> quads;
+    
+    void resize(int columnCount, int rowCount) {
+        columns = std::max(1, columnCount);
+        rows = std::max(1, rowCount);
+        accesses.assign(static_cast<size_t>(columns) * rows, 0);
+        misses.assign(accesses.size(), 0);
+    }
+    
+public:
+    HeatmapOverlay() :
+        elementCount(0),
+        gridWidth(0),
+        blockSize(1),
+        columns(1),
+        rows(1),
+        blockWidth(0),
+        blockHeight(0)
+    {
+    }
+    
+    void resetArray(size_t count, const sf::FloatRect& area) {
+        elementCount = count;
+        gridWidth = 0;
+        bounds = area;
+        resize(static_cast<int>(std::min<size_t>(std::max<size_t>(1, count),
+                                                 std::max<size_t>(1, static_cast<size_t>(area.width)))), 1);
+        blockWidth = area.width / columns;
+        blockHeight = area.height;
+    }
+    
+    // Uses the fitted, centred placement of GridRenderer
+    void resetGrid(const GridMap& grid, const sf::FloatRect& area) {
+        elementCount = grid.cellCount();
+        gridWidth = std::max(1, grid.width);
+        blockSize = std::max(1, (std::max(grid.width, grid.height) + 127) / 128);
+        resize((grid.width + blockSize - 1) / blockSize, (grid.height + blockSize - 1) / blockSize);
+        float cellSize = std::min(area.width / std::max(1, grid.width), area.height / std::max(1, grid.height));
+        bounds = sf::FloatRect(area.left + (area.width - cellSize * grid.width) / 2,
+                               area.top + (area.height - cellSize * grid.height) / 2,
+                               cellSize * grid.width, cellSize * grid.height);
+        blockWidth = cellSize * blockSize;
+        blockHeight = cellSize * blockSize;
+    }
+    
+    void clear() {
+        std::fill(accesses.begin(), accesses.end(), 0);
+        std::fill(misses.begin(), misses.end(), 0);
+    }
+    
+    void record(size_t element, bool miss) {
+        if (element >= elementCount) {
+            return;
+        }
+        size_t block = gridWidth == 0 ?
+            static_cast<size_t>(static_cast<uint64_t>(element) * columns / elementCount) :
+            (element / gridWidth / blockSize) * columns + (element % gridWidth) / blockSize;
+        accesses[block]++;
+        misses[block] += miss;
+    }
+    
+    // Returns the number of draw calls issued
+    unsigned draw(sf::RenderTarget& target) {
+        quads.clear();
+        for (int row = 0; row < rows; row++) {
+            for (int column = 0; column < columns; column++) {
+                size_t block = static_cast<size_t>(row) * columns + column;
+                if (accesses[block] == 0) {
+                    continue;
+                }
+                float heat = std::min(1.0f, 4.0f * misses[block] / accesses[block]);
+                sf::Color color(static_cast<sf::Uint8>(255 * std::min(1.0f, 2 * heat)),
+                                static_cast<sf::Uint8>(255 * std::min(1.0f, 2 - 2 * heat)), 40, 110);
+                float x = bounds.left + column * blockWidth;
+                float y = bounds.top + row * blockHeight;
+                float right = std::min(bounds.left + bounds.width, x + blockWidth);
+                float bottom = std::min(bounds.top + bounds.height, y + blockHeight);
+                quads.emplace_back(sf::Vector2f(x, y), color);
+                quads.emplace_back(sf::Vector2f(right, y), color);
+                quads.emplace_back(sf::Vector2f(right, bottom), color);
+                quads.emplace_back(sf::Vector2f(x, bottom), color);
+            }
+        }
+        if (quads.empty()) {
+            return 0;
+        }
+        target.draw(quads.data(), quads.size(), sf::Quads);
+        return 1;
+    }
+};
+
+// The array or grid a run works on, its renderer and the counts of the steps applied so far.
+// The visualizer shows one, and a race shows one per algorithm.
+struct RunView {
+    std::vector<int> data;
+    GridMap grid;
+    BarRenderer bars;
+    GridRenderer cells;
+    OpCounters counters;
+    size_t currentThread = 0; // worker thread of the steps being applied, 0 outside parallel sections
+    
+    // Cache mode: the steps' memory accesses also go through a simulated cache
+    bool simulateCache = false;
+    CacheSimulator cache;
+    HeatmapOverlay heat;
+    
+    // Array and grid writes go through these so the renderers know what changed
+    void swapBars(size_t i, size_t j) {
+        std::swap(data[i], data[j]);
+        bars.markDirty(i);
+        bars.markDirty(j);
+    }
+    
+    void setBar(size_t i, int value) {
+        data[i] = value;
+        bars.markDirty(i);
+    }
+    
+    void setCell(size_t cell, int state, size_t thread = 0) {
+        grid.cells[cell] = static_cast<uint8_t>(state);
+        cells.setCell(static_cast<int>(cell), state, thread);
+    }
+    
+    // Starts cache mode with cold caches and an empty heatmap, or stops it
+    void useCache(bool on, const CacheConfig& config) {
+        simulateCache = on;
+        if (on) {
+            cache.configure(config);
+        }
+        heat.clear();
+    }
+    
+    // Clears the marks of a previous search, leaving only free cells and obstacles
+    void clearSearch() {
+        for (size_t cell = 0; cell < grid.cellCount(); cell++) {
+            if (grid.cells[cell] >= 2) {
+                setCell(cell, 0);
+            }
+        }
+    }
+    
+    // Applies one recorded step to the array or grid
+    void applyStep(const StepEvent& step, bool pathfinding) {
+        counters.count(step);
+        if (simulateCache) {
+            stepAccesses(step, pathfinding ? &grid : nullptr, [this](uint64_t address, size_t element) {
+                heat.record(element, cache.access(address));
+            });
+        }
+        
+        switch (step.type()) {
+            case StepType::COMPARE:
+                bars.highlight(step.index());
+                bars.highlight(step.operand);
+                break;
+            case StepType::SWAP:
+                swapBars(step.index(), step.operand);
+                bars.highlight(step.index());
+                bars.highlight(step.operand);
+                if (currentThread) {
+                    bars.setOwner(step.index(), currentThread);
+                    bars.setOwner(step.operand, currentThread);
+                }
+                break;
+            case StepType::WRITE:
+                setBar(step.index(), step.value());
+                bars.highlight(step.index());
+                if (currentThread) {
+                    bars.setOwner(step.index(), currentThread);
+                }
+                break;
+            case StepType::VISIT:
+                setCell(step.index(), 2, currentThread);
+                break;
+            case StepType::PATH:
+                setCell(step.index(), 3);
+                break;
+            case StepType::READ:
+                // Grid reads (jump point scans) only show in the counters
+                if (!pathfinding) {
+                    bars.highlight(step.index());
+                }
+                break;
+            case StepType::PUSH:
+                setCell(step.index(), 4);
+                break;
+            case StepType::POP:
+                break;
+            case StepType::THREAD:
+                currentThread = step.index();
+                break;
+        }
+    }
+};
+
+// One algorithm of a race: its own copy of the input, worker thread and recorded steps,
+// and the part of the window it is drawn in
+struct RaceLane {
+    AlgorithmType algorithm;
+    RunView view;
+    SearchScratch scratch;
+    AlgorithmWorker worker;
+    std::vector<StepEvent> trace;
+    size_t cursor = 0;
+    bool truncated = false;
+    sf::FloatRect area;
+    
+    explicit RaceLane(AlgorithmType algorithm) : algorithm(algorithm) {}
+    
+    bool finished() const {
+        return cursor == trace.size() && (worker.done() || truncated);
+    }
+};
+
+class AlgorithmVisualizer {
+private:
+    sf::RenderWindow window;
+    RunView view; // the displayed input, its renderer and the counts of the replayed steps
+    AlgorithmType currentAlgorithm;
+    bool isRunning;
+    bool isPaused;
+    double stepsPerSecond; // playback rate
+    double stepCredit;     // fractional steps carried over between frames
+    int arraySize;
+    int maxValue;
+    
+    // For pathfinding algorithms
+    SearchScratch scratch; // owned by the worker while a search runs
+    int gridSize;          // side length of generated grids
+    
+    // Generated inputs are reproducible from the seed; R moves on to the next one
+    InputDistribution distribution;
+    GridPattern gridPattern;
+    uint64_t seed;
+    
+    // Inputs loaded from files replace the random ones until the size is changed
+    std::vector<int> loadedData;
+    int loadedMax;
+    GridMap loadedGrid;
+    
+    // UI elements
+    sf::Font font;
+    sf::Text algorithmText;
+    sf::Text instructionText;
+    sf::Text statsText;
+    
+    // Recorded steps of the current run and the replay position within them
+    static const size_t MAX_TRACE_STEPS = 64u * 1024 * 1024;
+    std::vector<StepEvent> trace;
+    size_t traceCursor;
+    bool traceTruncated;
+    bool runActive; // a run has been started and its replay has not finished
+    AlgorithmWorker worker;
+    
+    // Whether runs sample hardware counters
+    bool samplePerf;
+    
+    // Runs are recorded to recordPath when set; a loaded trace replaces running the algorithm
+    std::string recordPath;
+    TraceWriter recorder;
+    std::atomic<bool> recordOnly; // set once the trace is full: the worker still records, the window drops steps
+    std::unique_ptr<TraceReader> replay;
+    uint64_t replayBase;  // trace step of trace[0] while replaying
+    
+    // Race mode shows one lane per algorithm instead of the single run above
+    std::vector<AlgorithmType> raceAlgorithms; // chosen with --race; each family has defaults
+    std::vector<std::unique_ptr<RaceLane>> lanes;
+    bool racing;
+    sf::Text laneText;
+    
+    // Frames are only drawn when something changed; events and runs set this
+    bool needsRedraw;
+    
+    // Cache mode: M runs every step's accesses through a simulated L1/L2 and overlays a miss heatmap
+    bool cacheMode;
+    CacheConfig cacheConfig;
+    
+    // Frame profiler; F shows its overlay, and the timeline is saved to profilePath on exit when set
+    FrameProfiler profiler;
+    bool showProfile;
+    std::string profilePath;
+    sf::Text profileText;
+    std::chrono::steady_clock::time_point runStarted; // when the current run's workers were started
+    
+    void initializeWindow() {
+        window.create(sf::VideoMode(1200, 800), "Algorithm Visualizer");
+        window.setFramerateLimit(60);
+    }
+    
+    void initializeFont() {
+        if (!font.loadFromFile("arial.ttf")) {
+            std::cerr << "Failed to load font!" << std::endl;
+            // Continue with default font
+        }
+        
+        algorithmText.setFont(font);
+        algorithmText.setCharacterSize(20);
+        algorithmText.setFillColor(sf::Color::White);
+        algorithmText.setPosition(10, 10);
+        
+        instructionText.setFont(font);
+        instructionText.setCharacterSize(16);
+        instructionText.setFillColor(sf::Color::White);
+        instructionText.setPosition(10, 40);
+        
+        statsText.setFont(font);
+        statsText.setCharacterSize(14);
+        statsText.setFillColor(sf::Color(200, 200, 200));
+        statsText.setPosition(10, 62);
+        
+        laneText.setFont(font);
+        laneText.setCharacterSize(14);
+        laneText.setFillColor(sf::Color(200, 200, 200));
+        
+        profileText.setFont(font);
+        profileText.setCharacterSize(14);
+        profileText.setFillColor(sf::Color::White);
+    }
+    
+    // Restores the loaded array, or generates arraySize values from the seed and distribution
+    void generateData() {
+        if (!loadedData.empty()) {
+            view.data = loadedData;
+        } else {
+            generateArray(view.data, arraySize, maxValue, distribution, seed);
+        }
+        
+        resetBars();
+        clearTrace();
+        if (racing && !isPathfinding()) {
+            buildLanes();
+        }
+    }
+    
+    void resetBars() {
+        sf::FloatRect area(0, 50, static_cast<float>(window.getSize().x),
+                           static_cast<float>(window.getSize().y - 100));
+        view.bars.reset(view.data, loadedData.empty() ? maxValue : loadedMax, area);
+        view.heat.resetArray(view.data.size(), area);
+    }
+    
+    void initializeGrid() {
+        if (!loadedGrid.cells.empty()) {
+            view.grid = loadedGrid;
+        } else {
+            // 20% obstacles for the random and terrain patterns
+            generateGrid(view.grid, gridSize, gridSize, gridPattern, 20, seed);
+        }
+        
+        resetCells();
+        clearTrace();
+        if (racing && isPathfinding()) {
+            buildLanes();
+        }
+    }
+    
+    void resetCells() {
+        sf::FloatRect area(0, 100, static_cast<float>(window.getSize().x),
+                           static_cast<float>(window.getSize().y - 100));
+        view.cells.reset(view.grid, area);
+        view.heat.resetGrid(view.grid, area);
+    }
+    
+    void drawArray() {
+        window.clear(sf::Color(30, 30, 30));
+        
+        profiler.countDrawCalls(view.bars.draw(window, view.data));
+        if (cacheMode) {
+            profiler.countDrawCalls(view.heat.draw(window));
+        }
+        
+        // Draw UI text
+        algorithmText.setString(algorithmInfo(currentAlgorithm).name + inputLabel() + runStatus());
+        instructionText.setString("Controls: R-Reset | Space-Play/Pause | 1-5/Tab-Algorithm Selection | D-Distribution | +/- Speed Adjustment | [/] Size | P-HW Counters");
+        
+        drawText(algorithmText);
+        drawText(instructionText);
+        drawStats();
+    }
+    
+    void drawGrid() {
+        window.clear(sf::Color(30, 30, 30));
+        
+        profiler.countDrawCalls(view.cells.draw(window));
+        if (cacheMode) {
+            profiler.countDrawCalls(view.heat.draw(window));
+        }
+        
+        // Draw UI text
+        algorithmText.setString(algorithmInfo(currentAlgorithm).name + inputLabel() + runStatus());
+        instructionText.setString("Controls: R-Reset | Space-Play/Pause | 6-8/Tab-Algorithm Selection | G-Grid Pattern | +/- Speed Adjustment | [/] Size | P-HW Counters");
+        
+        drawText(algorithmText);
+        drawText(instructionText);
+        drawStats();
+    }
+    
+    // Live operation counters plus the simulated cache's and the worker's hardware counters, if enabled
+    void drawStats() {
+        std::string stats = view.counters.summary(isPathfinding());
+        if (cacheMode) {
+            stats += "\n" + view.cache.counters.summary(elementCount());
+        }
+        if (samplePerf) {
+            PerfSample sample = worker.perfSample();
+            stats += "\n" + (sample.valid ? sample.summary() : std::string("Hardware counters unavailable"));
+        }
+        
+        statsText.setString(stats);
+        drawText(statsText);
+    }
+    
+    void drawText(const sf::Text& text) {
+        window.draw(text);
+        profiler.countDrawCalls(1);
+    }
+    
+    // Profiler overlay in the top right corner: phase timings and a histogram of the
+    // last frames' times in 2 ms buckets, with frames slower than 60 fps in orange
+    void drawProfile() {
+        const size_t buckets = 24;
+        const double bucketMillis = 2;
+        float left = static_cast<float>(window.getSize().x) - 480;
+        float top = 8;
+        
+        std::vector<sf::Vertex> quads;
+        auto addQuad = [&quads](float x, float y, float w, float h, sf::Color color) {
+            quads.emplace_back(sf::Vector2f(x, y), color);
+            quads.emplace_back(sf::Vector2f(x + w, y), color);
+            quads.emplace_back(sf::Vector2f(x + w, y + h), color);
+            quads.emplace_back(sf::Vector2f(x, y + h), color);
+        };
+        addQuad(left, top, 472, 130, sf::Color(0, 0, 0, 200));
+        
+        std::vector<size_t> counts = profiler.histogram(buckets, bucketMillis);
+        size_t highest = std::max<size_t>(1, *std::max_element(counts.begin(), counts.end()));
+        for (size_t bucket = 0; bucket < buckets; bucket++) {
+            float height = 56.0f * counts[bucket] / highest;
+            bool slow = (bucket + 1) * bucketMillis > 1000.0 / 60;
+            addQuad(left + 8 + bucket * 19.0f, top + 122 - height, 17, height,
+                    slow ? sf::Color(230, 140, 40) : sf::Color(90, 200, 110));
+        }
+        window.draw(quads.data(), quads.size(), sf::Quads);
+        profiler.countDrawCalls(1);
+        
+        profileText.setString(profiler.summary());
+        profileText.setPosition(left + 8, top + 4);
+        drawText(profileText);
+    }
+    
+    void reportRun() const {
+        std::cout << algorithmInfo(currentAlgorithm).name << " on "
+                  << (isPathfinding() ? std::to_string(view.grid.width) + "x" + std::to_string(view.grid.height) + " grid"
+                                      : std::to_string(view.data.size()) + " elements")
+                  << ": " << view.counters.summary(isPathfinding()) << std::endl;
+        if (cacheMode) {
+            std::cout << "  " << view.cache.counters.summary(elementCount()) << std::endl;
+        }
+        
+        PerfSample sample = worker.perfSample();
+        if (sample.valid) {
+            std::cout << "  " << sample.summary() << std::endl;
+        }
+    }
+    
+    std::string runStatus() const {
+        if (replay) {
+            return "  |  Step " + std::to_string(replayBase + traceCursor) + " / " + std::to_string(replay->steps()) +
+                   "  |  " + rateLabel() + "  |  Replaying trace (Left/Right to seek)";
+        }
+        if (trace.empty()) {
+            return "  |  " + rateLabel();
+        }
+        
+        std::string status = "  |  Step " + std::to_string(traceCursor) + " / " + std::to_string(trace.size()) +
+                             "  |  " + rateLabel() +
+                             "  |  " + (worker.computed() ?
+                                        "Computed in " + std::to_string(static_cast<int>(worker.computeMillis())) + " ms" :
+                                        std::string("Computing..."));
+        if (traceTruncated) {
+            status += recordOnly && recorder.isOpen() ? " (trace limit reached, still recording)" : " (trace limit reached)";
+        }
+        return status;
+    }
+    
+    // Where the displayed input came from, unless it was loaded from a file
+    std::string inputLabel() const {
+        if (isPathfinding() ? !loadedGrid.cells.empty() : !loadedData.empty()) {
+            return "";
+        }
+        return std::string("  |  ") +
+               (isPathfinding() ? gridPatternInfo(gridPattern).name : distributionInfo(distribution).name) +
+               ", seed " + std::to_string(seed);
+    }
+    
+    std::string rateLabel() const {
+        if (stepsPerSecond >= 1000000) {
+            return std::to_string(static_cast<int>(stepsPerSecond / 1000000)) + "M steps/s";
+        }
+        if (stepsPerSecond >= 1000) {
+            return std::to_string(static_cast<int>(stepsPerSecond / 1000)) + "k steps/s";
+        }
+        return std::to_string(static_cast<int>(stepsPerSecond)) + " steps/s";
+    }
+    
+    // Applies as many steps as the playback rate allows for a frame of frameSeconds,
+    // giving up early if applying them would overrun the frame itself
+    void advancePlayback(double frameSeconds) {
+        const auto budget = std::chrono::milliseconds(12);
+        auto frameStart = std::chrono::steady_clock::now();
+        
+        stepCredit += stepsPerSecond * std::min(frameSeconds, 0.1);
+        size_t steps = static_cast<size_t>(stepCredit);
+        stepCredit -= steps;
+        
+        size_t first = traceCursor;
+        size_t end = std::min(trace.size(), traceCursor + steps);
+        while (traceCursor < end) {
+            size_t batchEnd = std::min(end, traceCursor + 4096);
+            while (traceCursor < batchEnd) {
+                view.applyStep(trace[traceCursor++], isPathfinding());
+            }
+            
+            if (std::chrono::steady_clock::now() - frameStart > budget) {
+                stepCredit = 0;
+                break;
+            }
+        }
+        
+        profiler.countSteps(traceCursor - first);
+        profiler.stepsApplied((replay ? replayBase : 0) + traceCursor);
+        
+        if (traceCursor == trace.size() && sourceDone()) {
+            isPaused = true;
+            runActive = false;
+            if (!replay) {
+                profiler.span(algorithmInfo(currentAlgorithm).name, 1, runStarted, worker.computeMillis());
+            }
+            reportRun();
+        }
+    }
+    
+    bool isPathfinding() const {
+        return algorithmInfo(currentAlgorithm).pathfinding;
+    }
+    
+    // Bars or grid cells in the current input, for the per-element cache figures
+    size_t elementCount() const {
+        return isPathfinding() ? view.grid.cellCount() : view.data.size();
+    }
+    
+    // True once every step of the run has reached the trace
+    bool sourceDone() const {
+        return replay ? replay->atEnd() : worker.done();
+    }
+    
+    void finishRecording() {
+        if (recorder.isOpen() && recorder.finish()) {
+            std::cout << "Saved " << recorder.stepCount() << " steps to " << recordPath << std::endl;
+        }
+    }
+    
+    // Shows the replayed trace's state at step `target` and continues decoding from there
+    void seekReplay(uint64_t target) {
+        TraceState state;
+        size_t thread = 0;
+        replay->seek(target, state, view.counters, thread);
+        view.useCache(cacheMode, cacheConfig); // the seek skips the accesses, so start from cold caches
+        profiler.resetSteps();
+        view.currentThread = thread;
+        trace.clear();
+        traceCursor = 0;
+        replayBase = replay->position();
+        
+        if (isPathfinding()) {
+            for (size_t cell = 0; cell < view.grid.cellCount(); cell++) {
+                if (view.grid.cells[cell] != state.cells[cell]) {
+                    view.setCell(cell, state.cells[cell]);
+                }
+            }
+        } else {
+            for (size_t i = 0; i < view.data.size(); i++) {
+                if (view.data[i] != state.values[i]) {
+                    view.setBar(i, state.values[i]);
+                }
+            }
+        }
+    }
+    
+    void clearTrace() {
+        // The worker writes the recording, so it has to stop before the file is closed
+        worker.stop();
+        finishRecording();
+        recordOnly = false;
+        runActive = false;
+        view.counters = OpCounters();
+        view.useCache(cacheMode, cacheConfig);
+        trace.clear();
+        traceCursor = 0;
+        traceTruncated = false;
+        view.currentThread = 0;
+        profiler.resetSteps();
+    }
+    
+    // Starts the current algorithm on the worker thread with its own copy of the input
+    void startRun() {
+        clearTrace();
+        runActive = true;
+        stepCredit = 0;
+        AlgorithmType algorithm = currentAlgorithm;
+        
+        if (replay) {
+            seekReplay(0);
+            return;
+        }
+        runStarted = std::chrono::steady_clock::now();
+        
+        if (isPathfinding()) {
+            // Reset grid to initial state before running algorithm
+            view.clearSearch();
+            
+            TraceWriter* writer = !recordPath.empty() && openTrace(recorder, recordPath, algorithm, view.grid) ?
+                                  &recorder : nullptr;
+            
+            // The window thread keeps writing cell states, so the search gets its own copy
+            SearchScratch* searchScratch = &scratch;
+            const std::atomic<bool>* detached = &recordOnly;
+            worker.start([algorithm, map = view.grid, searchScratch, writer, detached](QueueSink& out) {
+                runRecorded(out, writer, *detached, [&](auto& sink) {
+                    runPathfinding(algorithm, map, *searchScratch, sink);
+                });
+            }, samplePerf);
+        } else {
+            view.bars.clearOwners();
+            TraceWriter* writer = !recordPath.empty() && openTrace(recorder, recordPath, algorithm, view.data) ?
+                                  &recorder : nullptr;
+            const std::atomic<bool>* detached = &recordOnly;
+            worker.start([algorithm, work = view.data, writer, detached](QueueSink& out) mutable {
+                runRecorded(out, writer, *detached, [&](auto& sink) {
+                    runSort(algorithm, work, sink);
+                });
+            }, samplePerf);
+        }
+    }
+    
+    // Moves the worker's queued steps into the trace, within a small per-frame time budget
+    void drainWorker() {
+        if (replay) {
+            // Keep a window of decoded steps ahead of the cursor, dropping the replayed ones
+            if (trace.size() - traceCursor < (1 << 20) && !replay->atEnd()) {
+                trace.erase(trace.begin(), trace.begin() + traceCursor);
+                replayBase += traceCursor;
+                traceCursor = 0;
+                replay->read(trace, 1 << 20);
+                profiler.stepsArrived(replayBase + trace.size());
+            }
+            return;
+        }
+        
+        const auto budget = std::chrono::milliseconds(4);
+        auto begin = std::chrono::steady_clock::now();
+        
+        if (recordOnly) {
+            // Only the recording still wants the steps; drop whatever reached the queue
+            std::vector<StepEvent> dropped;
+            while (worker.drain(dropped, 1 << 16) > 0) {
+                dropped.clear();
+            }
+        }
+        
+        while (trace.size() < MAX_TRACE_STEPS) {
+            size_t room = std::min<size_t>(1 << 16, MAX_TRACE_STEPS - trace.size());
+            if (worker.drain(trace, room) == 0 || std::chrono::steady_clock::now() - begin > budget) {
+                break;
+            }
+        }
+        
+        profiler.stepsArrived(trace.size());
+        
+        if (trace.size() >= MAX_TRACE_STEPS && !worker.done()) {
+            traceTruncated = true;
+            if (recorder.isOpen()) {
+                recordOnly = true;
+            } else {
+                worker.stop();
+            }
+        }
+        
+        if (recorder.isOpen() && worker.done()) {
+            finishRecording();
+        }
+    }
+    
+    // Changes whenever the status line, the counters or the drawn array or grid would:
+    // steps drained or replayed, a worker finishing, or a run starting or ending
+    size_t progress() const {
+        size_t total = replayBase + traceCursor + trace.size() + worker.computed() + 2 * isPaused + 4 * runActive;
+        for (const auto& lane : lanes) {
+            total += lane->cursor + lane->trace.size() + lane->worker.computed();
+        }
+        return total;
+    }
+    
+    // True while a worker may still hand over steps, so the loop has to keep draining
+    bool workerBusy() const {
+        if (!runActive || replay) {
+            return false;
+        }
+        if (racing) {
+            for (const auto& lane : lanes) {
+                if (!lane->worker.done() && !lane->truncated) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        return !worker.done() && (!traceTruncated || recordOnly);
+    }
+    
+    // How long the loop sleeps when nothing changed: until the next step is due during
+    // playback, otherwise a short poll of the computing worker
+    std::chrono::microseconds pacingDelay() const {
+        double seconds = isPaused ? 0.016 : (1 - stepCredit) / stepsPerSecond;
+        return std::chrono::microseconds(static_cast<int64_t>(1e6 * std::min(0.05, std::max(0.001, seconds))));
+    }
+    
+    // Race mode: the chosen algorithms of the current family run at once, each on its own
+    // worker thread and copy of the displayed input, and are replayed side by side
+    std::vector<AlgorithmType> lineup() const {
+        std::vector<AlgorithmType> chosen;
+        for (AlgorithmType algorithm : raceAlgorithms) {
+            if (algorithmInfo(algorithm).pathfinding == isPathfinding()) {
+                chosen.push_back(algorithm);
+            }
+        }
+        if (chosen.empty()) {
+            chosen = isPathfinding() ?
+                std::vector<AlgorithmType>{AlgorithmType::BFS, AlgorithmType::DIJKSTRA,
+                                           AlgorithmType::ASTAR, AlgorithmType::JUMP_POINT_SEARCH} :
+                std::vector<AlgorithmType>{AlgorithmType::INSERTION_SORT, AlgorithmType::QUICK_SORT,
+                                           AlgorithmType::MERGE_SORT, AlgorithmType::RADIX_SORT};
+        }
+        return chosen;
+    }
+    
+    // Gives every algorithm of the lineup a fresh copy of the displayed input and a
+    // viewport in a near-square grid below the header
+    void buildLanes() {
+        lanes.clear();
+        std::vector<AlgorithmType> chosen = lineup();
+        size_t columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(chosen.size()))));
+        size_t rows = (chosen.size() + columns - 1) / columns;
+        float width = static_cast<float>(window.getSize().x) / columns;
+        float height = static_cast<float>(window.getSize().y - 100) / rows;
+        
+        for (size_t i = 0; i < chosen.size(); i++) {
+            std::unique_ptr<RaceLane> lane(new RaceLane(chosen[i]));
+            lane->area = sf::FloatRect(width * (i % columns), 100 + height * (i / columns), width, height);
+            sf::FloatRect content(lane->area.left + 4, lane->area.top + 40,
+                                  lane->area.width - 8, lane->area.height - 44);
+            if (isPathfinding()) {
+                lane->view.grid = view.grid;
+                lane->view.clearSearch();
+                lane->view.cells.reset(lane->view.grid, content);
+                lane->view.heat.resetGrid(lane->view.grid, content);
+            } else {
+                lane->view.data = view.data;
+                lane->view.bars.reset(lane->view.data, loadedData.empty() ? maxValue : loadedMax, content);
+                lane->view.heat.resetArray(lane->view.data.size(), content);
+            }
+            lane->view.useCache(cacheMode, cacheConfig);
+            lanes.push_back(std::move(lane));
+        }
+    }
+    
+    void toggleRace() {
+        racing = !racing;
+        replay.reset();
+        clearTrace();
+        isPaused = true;
+        if (racing) {
+            buildLanes();
+        } else {
+            lanes.clear();
+        }
+    }
+    
+    // Starts every lane's algorithm back to back so they compute concurrently
+    void startRace() {
+        clearTrace();
+        runActive = true;
+        stepCredit = 0;
+        buildLanes();
+        runStarted = std::chrono::steady_clock::now();
+        
+        for (auto& lane : lanes) {
+            AlgorithmType algorithm = lane->algorithm;
+            if (isPathfinding()) {
+                SearchScratch* searchScratch = &lane->scratch;
+                lane->worker.start([algorithm, map = lane->view.grid, searchScratch](QueueSink& out) {
+                    runPathfinding(algorithm, map, *searchScratch, out);
+                }, false);
+            } else {
+                lane->worker.start([algorithm, work = lane->view.data](QueueSink& out) mutable {
+                    runSort(algorithm, work, out);
+                }, false);
+            }
+        }
+    }
+    
+    // Drains the lanes in turn so no worker stalls on a full queue while the others run
+    void drainRace() {
+        const auto budget = std::chrono::milliseconds(4);
+        auto begin = std::chrono::steady_clock::now();
+        size_t limit = MAX_TRACE_STEPS / std::max<size_t>(1, lanes.size());
+        
+        bool drained = true;
+        while (drained && std::chrono::steady_clock::now() - begin <= budget) {
+            drained = false;
+            for (auto& lane : lanes) {
+                size_t room = std::min<size_t>(1 << 16, limit - std::min(limit, lane->trace.size()));
+                drained = (room > 0 && lane->worker.drain(lane->trace, room) > 0) || drained;
+            }
+        }
+        
+        for (auto& lane : lanes) {
+            if (lane->trace.size() >= limit && !lane->worker.done() && !lane->truncated) {
+                lane->truncated = true;
+                lane->worker.stop();
+            }
+        }
+    }
+    
+    // Replays the same number of steps in every lane, sharing the frame budget between them
+    void advanceRace(double frameSeconds) {
+        const auto budget = std::chrono::milliseconds(12);
+        auto frameStart = std::chrono::steady_clock::now();
+        
+        stepCredit += stepsPerSecond * std::min(frameSeconds, 0.1);
+        size_t steps = static_cast<size_t>(stepCredit);
+        stepCredit -= steps;
+        
+        for (size_t done = 0; done < steps; done += 4096) {
+            size_t batch = std::min<size_t>(4096, steps - done);
+            for (auto& lane : lanes) {
+                size_t end = std::min(lane->trace.size(), lane->cursor + batch);
+                profiler.countSteps(end - std::min(end, lane->cursor));
+                while (lane->cursor < end) {
+                    lane->view.applyStep(lane->trace[lane->cursor++], isPathfinding());
+                }
+            }
+            
+            if (std::chrono::steady_clock::now() - frameStart > budget) {
+                stepCredit = 0;
+                break;
+            }
+        }
+        
+        bool finished = true;
+        for (const auto& lane : lanes) {
+            finished = finished && lane->finished();
+        }
+        if (finished) {
+            isPaused = true;
+            runActive = false;
+            for (size_t i = 0; i < lanes.size(); i++) {
+                profiler.span(algorithmInfo(lanes[i]->algorithm).name, static_cast<int>(i + 1), runStarted,
+                              lanes[i]->worker.computeMillis());
+            }
+            reportRace();
+        }
+    }
+    
+    // Position of a lane among the lanes whose algorithm has finished computing, from 1
+    size_t place(const RaceLane& lane) const {
+        size_t ahead = 0;
+        for (const auto& other : lanes) {
+            ahead += other->worker.computed() && other->worker.computeMillis() < lane.worker.computeMillis();
+        }
+        return ahead + 1;
+    }
+    
+    void reportRace() const {
+        std::vector<const RaceLane*> order;
+        for (const auto& lane : lanes) {
+            order.push_back(lane.get());
+        }
+        std::sort(order.begin(), order.end(), [](const RaceLane* a, const RaceLane* b) {
+            return a->worker.computeMillis() < b->worker.computeMillis();
+        });
+        
+        std::cout << "Race on "
+                  << (isPathfinding() ? std::to_string(view.grid.width) + "x" + std::to_string(view.grid.height) + " grid"
+                                      : std::to_string(view.data.size()) + " elements")
+                  << ":" << std::endl;
+        for (size_t i = 0; i < order.size(); i++) {
+            std::cout << "  " << i + 1 << ". " << algorithmInfo(order[i]->algorithm).name << " in "
+                      << order[i]->worker.computeMillis() << " ms: "
+                      << order[i]->view.counters.summary(isPathfinding())
+                      << (order[i]->truncated ? " (trace limit reached)" : "") << std::endl;
+            if (cacheMode) {
+                std::cout << "     " << order[i]->view.cache.counters.summary(elementCount()) << std::endl;
+            }
+        }
+    }
+    
+    void drawRace() {
+        window.clear(sf::Color(30, 30, 30));
+        
+        std::string names;
+        for (const auto& lane : lanes) {
+            names += (names.empty() ? "" : " vs ") + std::string(algorithmInfo(lane->algorithm).name);
+        }
+        algorithmText.setString("Race: " + names + "  |  " + rateLabel());
+        instructionText.setString("Controls: R-Reset | Space-Play/Pause | C-Leave Race | Tab-Switch Family | +/- Speed Adjustment | [/] Size");
+        drawText(algorithmText);
+        drawText(instructionText);
+        
+        for (const auto& lane : lanes) {
+            if (isPathfinding()) {
+                profiler.countDrawCalls(lane->view.cells.draw(window));
+            } else {
+                profiler.countDrawCalls(lane->view.bars.draw(window, lane->view.data));
+            }
+            if (cacheMode) {
+                profiler.countDrawCalls(lane->view.heat.draw(window));
+            }
+            
+            std::string status = algorithmInfo(lane->algorithm).name;
+            if (!lane->trace.empty()) {
+                status += "  |  Step " + std::to_string(lane->cursor) + " / " + std::to_string(lane->trace.size()) +
+                          "  |  " + (lane->worker.computed() ?
+                                     "#" + std::to_string(place(*lane)) + " in " +
+                                     std::to_string(static_cast<int>(lane->worker.computeMillis())) + " ms" :
+                                     std::string("Computing..."));
+                if (lane->truncated) {
+                    status += " (trace limit reached)";
+                }
+            }
+            laneText.setString(status + "\n" + lane->view.counters.summary(isPathfinding()) +
+                               (cacheMode ? "\n" + lane->view.cache.counters.summary(elementCount()) : ""));
+            laneText.setPosition(lane->area.left + 6, lane->area.top + 4);
+            drawText(laneText);
+        }
+    }
+    
+    void selectAlgorithm(AlgorithmType algorithm) {
+        replay.reset();
+        currentAlgorithm = algorithm;
+        if (isPathfinding()) {
+            initializeGrid();
+        } else {
+            generateData();
+        }
+        isPaused = true;
+    }
+    
+public:
+    AlgorithmVisualizer() :
+        isRunning(false),
+        isPaused(false),
+        stepsPerSecond(20),
+        stepCredit(0),
+        arraySize(100),
+        maxValue(500),
+        currentAlgorithm(AlgorithmType::BUBBLE_SORT),
+        gridSize(20),
+        distribution(InputDistribution::UNIFORM),
+        gridPattern(GridPattern::RANDOM),
+        seed((static_cast<uint64_t>(std::random_device()()) << 32) | std::random_device()()),
+        loadedMax(0),
+        traceCursor(0),
+        traceTruncated(false),
+        runActive(false),
+        samplePerf(false),
+        recordOnly(false),
+        replayBase(0),
+        racing(false),
+        needsRedraw(true),
+        cacheMode(false),
+        showProfile(false)
+    {
+        initializeWindow();
+        initializeFont();
+        generateData();
+        initializeGrid();
+    }
+    
+    ~AlgorithmVisualizer() {
+        // The worker writes the recording, so it has to stop before the file is closed
+        worker.stop();
+        finishRecording();
+        window.close();
+    }
+    
+    bool loadArray(const std::string& path) {
+        std::vector<int> values;
+        if (!loadArrayFile(path, values)) {
+            return false;
+        }
+        if (values.size() > StepEvent::INDEX_MASK) {
+            std::cerr << path << " has more elements than a trace can address" << std::endl;
+            return false;
+        }
+        loadedMax = std::max(1, *std::max_element(values.begin(), values.end()));
+        loadedData = std::move(values);
+        generateData();
+        return true;
+    }
+    
+    // Replace the random seed and the distribution of the generated inputs
+    void setSeed(uint64_t inputSeed) {
+        seed = inputSeed;
+        generateData();
+        initializeGrid();
+    }
+    
+    void setDistribution(InputDistribution inputDistribution) {
+        distribution = inputDistribution;
+        generateData();
+    }
+    
+    void setGridPattern(GridPattern pattern) {
+        gridPattern = pattern;
+        initializeGrid();
+    }
+    
+    // Simulates the given caches for every run's accesses; the input is restored so runs start over
+    void setCacheMode(bool on, const CacheConfig& config) {
+        cacheMode = on;
+        cacheConfig = config;
+        if (isPathfinding()) {
+            initializeGrid();
+        } else {
+            generateData();
+        }
+    }
+    
+    void recordTo(const std::string& path) {
+        recordPath = path;
+    }
+    
+    // Keeps a timeline of every frame and saves it as Chrome trace JSON on exit
+    void profileTo(const std::string& path) {
+        profilePath = path;
+        profiler.setRecording(true);
+    }
+    
+    // Shows a recorded run instead of running the algorithm; R restarts it
+    bool loadReplay(const std::string& path) {
+        std::unique_ptr<TraceReader> reader(new TraceReader());
+        if (!reader->open(path)) {
+            return false;
+        }
+        
+        const TraceHeader& info = reader->info();
+        bool known = false;
+        for (const auto& entry : ALGORITHMS) {
+            known = known || (entry.type == info.algorithm && entry.pathfinding == info.pathfinding);
+        }
+        uint64_t cellCount = static_cast<uint64_t>(info.width) * info.height;
+        bool sized = info.stateCount > 0 && info.stateCount <= StepEvent::INDEX_MASK &&
+                     (info.pathfinding ? cellCount == info.stateCount && info.start >= 0 && info.end >= 0 &&
+                                         static_cast<uint64_t>(std::max(info.start, info.end)) < cellCount
+                                       : info.width == info.stateCount);
+        TraceState state;
+        OpCounters initial;
+        size_t thread = 0;
+        if (!known || !sized || !reader->seek(0, state, initial, thread)) {
+            std::cerr << path << " does not describe a run this visualizer can show" << std::endl;
+            return false;
+        }
+        
+        racing = false;
+        lanes.clear();
+        currentAlgorithm = info.algorithm;
+        if (info.pathfinding) {
+            loadedGrid.width = static_cast<int>(info.width);
+            loadedGrid.height = static_cast<int>(info.height);
+            loadedGrid.cells = std::move(state.cells);
+            loadedGrid.start = info.start;
+            loadedGrid.end = info.end;
+            initializeGrid();
+        } else {
+            loadedData.assign(state.values.begin(), state.values.end());
+            loadedMax = std::max(1, *std::max_element(loadedData.begin(), loadedData.end()));
+            generateData();
+        }
+        replay = std::move(reader);
+        return true;
+    }
+    
+    // Starts in race mode with the given algorithms; the first one picks the family shown
+    void race(const std::vector<AlgorithmType>& algorithms) {
+        raceAlgorithms = algorithms;
+        if (!algorithms.empty() && algorithmInfo(algorithms[0]).pathfinding != isPathfinding()) {
+            selectAlgorithm(algorithms[0]);
+        }
+        if (!racing) {
+            toggleRace();
+        } else {
+            buildLanes();
+        }
+    }
+    
+    bool loadGrid(const std::string& path) {
+        if (!loadGridFile(path, loadedGrid)) {
+            loadedGrid = GridMap();
+            return false;
+        }
+        initializeGrid();
+        return true;
+    }
+    
+    void handleEvents() {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            handleEvent(event);
+        }
+    }
+    
+    // Blocks until the next window event and handles it
+    void waitForEvent() {
+        sf::Event event;
+        if (window.waitEvent(event)) {
+            handleEvent(event);
+        }
+    }
+    
+    void handleEvent(const sf::Event& event) {
+        // Anything but mouse movement may change what is shown
+        needsRedraw = needsRedraw || event.type != sf::Event::MouseMoved;
+        
+        if (event.type == sf::Event::Closed) {
+            window.close();
+            isRunning = false;
+        }
+        
+        if (event.type == sf::Event::KeyPressed) {
+            switch (event.key.code) {
+                case sf::Keyboard::Escape:
+                    window.close();
+                    isRunning = false;
+                    break;
+                
+                case sf::Keyboard::R:
+                    seed = splitmix64(seed);
+                    generateData();
+                    initializeGrid();
+                    isPaused = true;
+                    break;
+                
+                case sf::Keyboard::Space:
+                    isPaused = !isPaused;
+                    break;
+                
+                case sf::Keyboard::Left:
+                case sf::Keyboard::Right:
+                    if (replay) {
+                        uint64_t jump = std::max<uint64_t>(1, replay->steps() / 20);
+                        uint64_t here = replayBase + traceCursor;
+                        seekReplay(event.key.code == sf::Keyboard::Right ? here + jump : here - std::min(here, jump));
+                        runActive = true;
+                    }
+                    break;
+                
+                case sf::Keyboard::Add:
+                case sf::Keyboard::Equal:
+                    stepsPerSecond = std::min(16777216.0, stepsPerSecond * 2);
+                    break;
+                
+                case sf::Keyboard::Subtract:
+                case sf::Keyboard::Dash:
+                    stepsPerSecond = std::max(1.0, stepsPerSecond / 2);
+                    break;
+                
+                case sf::Keyboard::LBracket:
+                case sf::Keyboard::RBracket:
+                    resize(event.key.code == sf::Keyboard::RBracket);
+                    isPaused = true;
+                    break;
+                
+                case sf::Keyboard::P:
+                    samplePerf = !samplePerf;
+                    break;
+                
+                case sf::Keyboard::C:
+                    toggleRace();
+                    break;
+                
+                case sf::Keyboard::F:
+                    showProfile = !showProfile;
+                    break;
+                
+                case sf::Keyboard::M:
+                    setCacheMode(!cacheMode, cacheConfig);
+                    isPaused = true;
+                    break;
+                
+                case sf::Keyboard::G: {
+                    // Cycles the generated grid's pattern, keeping the seed
+                    size_t count = sizeof(GRID_PATTERNS) / sizeof(GRID_PATTERNS[0]);
+                    size_t current = &gridPatternInfo(gridPattern) - GRID_PATTERNS;
+                    gridPattern = GRID_PATTERNS[(current + (event.key.shift ? count - 1 : 1)) % count].pattern;
+                    if (isPathfinding()) {
+                        loadedGrid = GridMap();
+                        initializeGrid();
+                        isPaused = true;
+                    }
+                    break;
+                }
+                
+                case sf::Keyboard::D: {
+                    // Cycles the generated array's distribution, keeping the seed
+                    size_t count = sizeof(DISTRIBUTIONS) / sizeof(DISTRIBUTIONS[0]);
+                    size_t current = &distributionInfo(distribution) - DISTRIBUTIONS;
+                    distribution = DISTRIBUTIONS[(current + (event.key.shift ? count - 1 : 1)) % count].distribution;
+                    if (!isPathfinding()) {
+                        loadedData.clear();
+                        generateData();
+                        isPaused = true;
+                    }
+                    break;
+                }
+                
+                case sf::Keyboard::Tab: {
+                    // Cycles through every algorithm, including those without a number key
+                    size_t count = sizeof(ALGORITHMS) / sizeof(ALGORITHMS[0]);
+                    size_t current = &algorithmInfo(currentAlgorithm) - ALGORITHMS;
+                    size_t next = (current + (event.key.shift ? count - 1 : 1)) % count;
+                    selectAlgorithm(ALGORITHMS[next].type);
+                    break;
                 }
-                current = prev;
                 
-                drawGrid();
-                delay();
+                case sf::Keyboard::Num1:
+                    selectAlgorithm(AlgorithmType::BUBBLE_SORT);
+                    break;
+                
+                case sf::Keyboard::Num2:
+                    selectAlgorithm(AlgorithmType::INSERTION_SORT);
+                    break;
+                
+                case sf::Keyboard::Num3:
+                    selectAlgorithm(AlgorithmType::SELECTION_SORT);
+                    break;
+                
+                case sf::Keyboard::Num4:
+                    selectAlgorithm(AlgorithmType::QUICK_SORT);
+                    break;
+                
+                case sf::Keyboard::Num5:
+                    selectAlgorithm(AlgorithmType::MERGE_SORT);
+                    break;
+                
+                case sf::Keyboard::Num6:
+                    selectAlgorithm(AlgorithmType::BFS);
+                    break;
+                
+                case sf::Keyboard::Num7:
+                    selectAlgorithm(AlgorithmType::DFS);
+                    break;
+                
+                case sf::Keyboard::Num8:
+                    selectAlgorithm(AlgorithmType::DIJKSTRA);
+                    break;
             }
         }
     }
     
-    void dijkstra() {
-        // Priority queue with min-heap, stores pairs of (distance, position)
-        std::priority_queue<std::pair<int, sf::Vector2i>, 
-                             std::vector<std::pair<int, sf::Vector2i>>,
-                             std::greater<std::pair<int, sf::Vector2i>>> pq;
-        
-        std::vector<std::vector<int>> distance(gridSize, std::vector<int>(gridSize, INT_MAX));
-        std::vector<std::vector<sf::Vector2i>> parent(gridSize, std::vector<sf::Vector2i>(gridSize, sf::Vector2i(-1, -1)));
-        
-        // Directions: up, right, down, left + diagonals
-        std::vector<sf::Vector2i> directions = {
-            sf::Vector2i(0, -1), sf::Vector2i(1, 0),
-            sf::Vector2i(0, 1), sf::Vector2i(-1, 0),
-            sf::Vector2i(1, -1), sf::Vector2i(1, 1),
-            sf::Vector2i(-1, 1), sf::Vector2i(-1, -1)
-        };
-        
-        // Start with distance 0 for the start point
-        pq.push({0, startPoint});
-        distance[startPoint.x][startPoint.y] = 0;
+    // Doubles or halves the array length or the grid side for the current algorithm family
+    void resize(bool grow) {
+        replay.reset();
+        if (isPathfinding()) {
+            loadedGrid = GridMap();
+            gridSize = grow ? std::min(2048, gridSize * 2) : std::max(10, gridSize / 2);
+            initializeGrid();
+        } else {
+            loadedData.clear();
+            arraySize = grow ? std::min(1 << 27, arraySize * 2) : std::max(10, arraySize / 2);
+            generateData();
+        }
+    }
+    
+    void runVisualization() {
+        isRunning = true;
+        isPaused = true;  // Start paused
         
-        bool foundPath = false;
+        auto lastFrame = std::chrono::steady_clock::now();
         
-        while (!pq.empty() && isRunning && !isPaused) {
-            auto [dist, current] = pq.top();
-            pq.pop();
-            
-            if (current == endPoint) {
-                foundPath = true;
-                break;
+        while (window.isOpen() && isRunning) {
+            profiler.beginFrame();
+            {
+                FrameProfiler::Scope scope(profiler, FrameProfiler::EVENTS);
+                handleEvents();
             }
             
-            // Skip if we've found a better path already
-            if (dist > distance[current.x][current.y]) {
-                continue;
+            auto now = std::chrono::steady_clock::now();
+            double frameSeconds = std::chrono::duration<double>(now - lastFrame).count();
+            lastFrame = now;
+            size_t before = progress();
+            
+            {
+                FrameProfiler::Scope scope(profiler, FrameProfiler::DRAIN);
+                if (!isPaused && !runActive) {
+                    if (racing) {
+                        startRace();
+                    } else {
+                        startRun();
+                    }
+                }
+                
+                if (racing) {
+                    drainRace();
+                } else {
+                    drainWorker();
+                }
             }
             
-            // Mark as visited in the grid
-            if (current != startPoint && current != endPoint) {
-                grid[current.x][current.y] = 2;
+            if (!isPaused) {
+                FrameProfiler::Scope scope(profiler, FrameProfiler::PLAYBACK);
+                if (racing) {
+                    advanceRace(frameSeconds);
+                } else {
+                    advancePlayback(frameSeconds);
+                }
             }
             
-            for (const auto& dir : directions) {
-                sf::Vector2i next(current.x + dir.x, current.y + dir.y);
-                
-                // Check if next position is valid
-                if (next.x >= 0 && next.x < gridSize && next.y >= 0 && next.y < gridSize && grid[next.x][next.y] != 1) {
-                    // Calculate weight (1 for cardinal directions, sqrt(2) for diagonals)
-                    int weight = (std::abs(dir.x) + std::abs(dir.y) == 1) ? 1 : 14; // Using 14 for sqrt(2)*10
-                    
-                    int newDist = distance[current.x][current.y] + weight;
-                    
-                    if (newDist < distance[next.x][next.y]) {
-                        distance[next.x][next.y] = newDist;
-                        parent[next.x][next.y] = current;
-                        pq.push({newDist, next});
+            // Redraw only when something visible changed; the window's frame rate limit
+            // paces the loop while every frame changes
+            bool drawn = needsRedraw || progress() != before;
+            if (drawn) {
+                {
+                    FrameProfiler::Scope scope(profiler, FrameProfiler::DRAW);
+                    if (racing) {
+                        drawRace();
+                    } else if (isPathfinding()) {
+                        drawGrid();
+                    } else {
+                        drawArray();
                     }
+                    if (showProfile) {
+                        drawProfile();
+                    }
+                }
+                {
+                    FrameProfiler::Scope scope(profiler, FrameProfiler::PRESENT);
+                    window.display();
                 }
+                needsRedraw = false;
             }
             
-            drawGrid();
-            delay();
-            
-            // Handle window events
-            handleEvents();
-            
-            if (isPaused) {
-                while (isPaused && isRunning) {
-                    handleEvents();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
+            // Paused with no worker left to drain, nothing can change until the next event
+            FrameProfiler::Scope scope(profiler, FrameProfiler::SLEEP);
+            if (isPaused && !workerBusy()) {
+                waitForEvent();
+            } else if (!drawn) {
+                std::this_thread::sleep_for(pacingDelay());
             }
         }
         
-        // Reconstruct path
-        if (foundPath) {
-            sf::Vector2i current = endPoint;
-            while (current != startPoint) {
-                sf::Vector2i prev = parent[current.x][current.y];
-                if (prev != startPoint) {
-                    grid[prev.x][prev.y] = 3; // Path
+        if (!profilePath.empty() && profiler.exportTrace(profilePath)) {
+            std::cout << "Saved frame profile to " << profilePath << std::endl;
+        }
+    }
+};
+
+// Headless benchmark mode: runs the algorithms without opening a window and
+// reports timings and operation counts as JSON or CSV
+struct BenchOptions {
+    std::vector<AlgorithmType> algorithms;
+    std::vector<size_t> sizes = {1000, 10000, 100000}; // array lengths for sorting algorithms
+    std::vector<size_t> gridSizes = {64, 256, 1024};   // grid sides for pathfinding algorithms
+    InputDistribution distribution = InputDistribution::UNIFORM;
+    int maxValue = 1000000000;
+    int obstaclePercent = 20;
+    GridPattern gridPattern = GridPattern::RANDOM;
+    uint64_t seed = 42;
+    int warmup = 1;
+    int reps = 5;
+    size_t quadraticLimit = 200000; // larger inputs skip the O(n^2) sorts
+    std::vector<unsigned> threads = {0}; // thread limits for the parallel algorithms, 0 = all
+    std::string arrayFile; // replaces the generated arrays when set
+    std::string mapFile;   // replaces the generated grids when set
+    std::string traceFile; // records the operation-counting run when set
+    bool csv = false;
+    bool perf = false;
+};
+
+struct BenchResult {
+    const AlgorithmInfo* algorithm;
+    size_t size;
+    unsigned threads;
+    size_t elements;
+    std::vector<double> millis; // one entry per timed repetition, sorted
+    OpCounters counters;
+    PerfSample perf; // hardware counters of the last timed repetition
+    long peakMemoryKB; // peak RSS during this configuration, -1 where it cannot be measured per run
+    bool verified;
+};
+
+// Process-wide peak resident set size in KiB, or 0 where unsupported
+inline long processPeakMemoryKB() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Starts a new peak RSS measurement by resetting the kernel's high-water mark
+// (Linux 4.0+); false where the process peak cannot be reset
+inline bool resetPeakMemory() {
+#if defined(__linux__)
+    FILE* file = std::fopen("/proc/self/clear_refs", "w");
+    if (!file) {
+        return false;
+    }
+    bool reset = std::fputs("5", file) >= 0;
+    return std::fclose(file) == 0 && reset;
+#else
+    return false;
+#endif
+}
+
+// Peak resident set size in KiB since the last resetPeakMemory(), or -1 where unsupported
+inline long peakMemoryKB() {
+#if defined(__linux__)
+    FILE* file = std::fopen("/proc/self/status", "r");
+    if (!file) {
+        return -1;
+    }
+    char line[256];
+    long peak = -1;
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::strncmp(line, "VmHWM:", 6) == 0) {
+            peak = std::atol(line + 6);
+            break;
+        }
+    }
+    std::fclose(file);
+    return peak;
+#else
+    return -1;
+#endif
+}
+
+// Quick Sort pivots on the last element, so it is quadratic on anything but random
+// input: sorted runs, few unique values or the killer sequence
+inline bool isQuadratic(AlgorithmType type, bool randomInput) {
+    return type == AlgorithmType::BUBBLE_SORT ||
+           type == AlgorithmType::INSERTION_SORT ||
+           type == AlgorithmType::SELECTION_SORT ||
+           (type == AlgorithmType::QUICK_SORT && !randomInput);
+}
+
+// Algorithms whose running time depends on threadLimit()
+inline bool isParallel(AlgorithmType type) {
+    return type == AlgorithmType::PARALLEL_MERGE_SORT ||
+           type == AlgorithmType::PARALLEL_QUICK_SORT ||
+           type == AlgorithmType::COUNTING_SORT ||
+           type == AlgorithmType::RADIX_SORT ||
+           type == AlgorithmType::PARALLEL_BFS;
+}
+
+// The single-threaded algorithm a parallel one is measured against
+inline AlgorithmType serialBaseline(AlgorithmType type) {
+    switch (type) {
+        case AlgorithmType::PARALLEL_MERGE_SORT: return AlgorithmType::MERGE_SORT;
+        case AlgorithmType::PARALLEL_QUICK_SORT: return AlgorithmType::QUICK_SORT;
+        case AlgorithmType::PARALLEL_BFS: return AlgorithmType::BFS;
+        default: return type;
+    }
+}
+
+inline std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        if (end > begin) {
+            items.push_back(list.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return items;
+}
+
+inline void printBenchUsage() {
+    std::cerr << "Usage: algorithm_visualizer --bench [options]\n"
+                 "  --algo LIST            comma-separated algorithms or 'all' (default all)\n"
+                 "                         bubble, insertion, selection, quick, quick-parallel, merge,\n"
+                 "                         merge-bottom-up, merge-parallel, counting, radix, bitonic, bfs,\n"
+                 "                         bfs-bits, bfs-bidirectional, bfs-parallel, dfs, dijkstra,\n"
+                 "                         dijkstra-bucket, astar, astar-octile, jps\n"
+                 "  --sizes LIST           array lengths, e.g. 1e3,1e6,1e8 (default 1e3,1e4,1e5)\n"
+                 "  --grid-sizes LIST      grid sides, e.g. 256,8192 (default 64,256,1024)\n"
+                 "  --dist NAME            uniform, sorted, reversed, few-unique, nearly-sorted,\n"
+                 "                         organ-pipe, qsort-killer (default uniform)\n"
+                 "  --max-value N          largest generated value (default 1e9)\n"
+                 "  --grid NAME            random, division, eller, caves, terrain (default random)\n"
+                 "  --obstacles PERCENT    obstacle density of random and terrain grids (default 20)\n"
+                 "  --array FILE           sort a raw int32 array (int64 if FILE ends in .i64)\n"
+                 "                         instead of generated ones\n"
+                 "  --map FILE             search a MovingAI .map or PGM grid instead of generated ones\n"
+                 "  --record FILE          write a trace of the run (one algorithm, size and thread limit)\n"
+                 "  --seed N               input seed (default 42)\n"
+                 "  --warmup N             untimed runs per configuration (default 1)\n"
+                 "  --reps N               timed runs per configuration (default 5)\n"
+                 "  --quadratic-limit N    skip O(n^2) sorts above this length, including quick on\n"
+                 "                         non-uniform inputs (default 2e5)\n"
+                 "  --threads LIST         thread limits for the parallel algorithms, e.g. 1,2,4,8\n"
+                 "                         (default all hardware threads)\n"
+                 "  --format json|csv      output format (default json)\n"
+                 "  --perf on|off          sample hardware counters with perf_event_open (default off)\n";
+}
+
+inline bool parseBenchOptions(int argc, char* argv[], BenchOptions& options) {
+    try {
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--help") {
+                return false;
+            }
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+            std::string value = argv[++i];
+            
+            if (arg == "--algo") {
+                for (const auto& key : splitList(value)) {
+                    bool known = false;
+                    for (const auto& info : ALGORITHMS) {
+                        if (key == "all" || key == info.key) {
+                            options.algorithms.push_back(info.type);
+                            known = true;
+                        }
+                    }
+                    if (!known) {
+                        std::cerr << "Unknown algorithm: " << key << std::endl;
+                        return false;
+                    }
                 }
-                current = prev;
-                
-                drawGrid();
-                delay();
+            } else if (arg == "--sizes" || arg == "--grid-sizes") {
+                std::vector<size_t>& target = arg == "--sizes" ? options.sizes : options.gridSizes;
+                target.clear();
+                for (const auto& item : splitList(value)) {
+                    double size = std::stod(item);
+                    if (size < 1) {
+                        std::cerr << "Invalid size: " << item << std::endl;
+                        return false;
+                    }
+                    target.push_back(static_cast<size_t>(size));
+                }
+            } else if (arg == "--dist") {
+                bool known = false;
+                for (const auto& info : DISTRIBUTIONS) {
+                    if (value == info.key) {
+                        options.distribution = info.distribution;
+                        known = true;
+                    }
+                }
+                if (!known) {
+                    std::cerr << "Unknown distribution: " << value << std::endl;
+                    return false;
+                }
+            } else if (arg == "--max-value") {
+                double maxValue = std::stod(value);
+                if (!(maxValue <= INT_MAX)) {
+                    std::cerr << "Invalid max value (at most " << INT_MAX << "): " << value << std::endl;
+                    return false;
+                }
+                options.maxValue = std::max(10, static_cast<int>(maxValue));
+            } else if (arg == "--obstacles") {
+                options.obstaclePercent = std::stoi(value);
+            } else if (arg == "--grid") {
+                bool known = false;
+                for (const auto& info : GRID_PATTERNS) {
+                    if (value == info.key) {
+                        options.gridPattern = info.pattern;
+                        known = true;
+                    }
+                }
+                if (!known) {
+                    std::cerr << "Unknown grid pattern: " << value << std::endl;
+                    return false;
+                }
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(value);
+            } else if (arg == "--warmup") {
+                options.warmup = std::max(0, std::stoi(value));
+            } else if (arg == "--reps") {
+                options.reps = std::max(1, std::stoi(value));
+            } else if (arg == "--quadratic-limit") {
+                options.quadraticLimit = static_cast<size_t>(std::stod(value));
+            } else if (arg == "--array") {
+                options.arrayFile = value;
+            } else if (arg == "--map") {
+                options.mapFile = value;
+            } else if (arg == "--record") {
+                options.traceFile = value;
+            } else if (arg == "--threads") {
+                options.threads.clear();
+                for (const auto& item : splitList(value)) {
+                    options.threads.push_back(static_cast<unsigned>(std::max(1, std::stoi(item))));
+                }
+                if (options.threads.empty()) {
+                    options.threads.push_back(0);
+                }
+            } else if (arg == "--format") {
+                if (value != "json" && value != "csv") {
+                    std::cerr << "Unknown format: " << value << std::endl;
+                    return false;
+                }
+                options.csv = value == "csv";
+            } else if (arg == "--perf") {
+                options.perf = value == "on";
+            } else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return false;
             }
         }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid numeric option value" << std::endl;
+        return false;
     }
     
-public:
-    AlgorithmVisualizer() :
-        isRunning(false),
-        isPaused(false),
-        speed(50),
-        arraySize(100),
-        maxValue(500),
-        currentAlgorithm(AlgorithmType::BUBBLE_SORT),
-        gridSize(20)
-    {
-        initializeWindow();
-        initializeFont();
-        generateRandomData();
-        initializeGrid();
+    if (options.algorithms.empty()) {
+        for (const auto& info : ALGORITHMS) {
+            options.algorithms.push_back(info.type);
+        }
     }
     
-    ~AlgorithmVisualizer() {
-        window.close();
+    if (!options.traceFile.empty()) {
+        bool pathfinding = algorithmInfo(options.algorithms[0]).pathfinding;
+        size_t sizes = pathfinding ? (options.mapFile.empty() ? options.gridSizes.size() : 1)
+                                   : (options.arrayFile.empty() ? options.sizes.size() : 1);
+        if (options.algorithms.size() != 1 || sizes != 1 || options.threads.size() != 1) {
+            std::cerr << "--record needs a single algorithm, size and thread limit" << std::endl;
+            return false;
+        }
     }
+    return true;
+}
+
+inline BenchResult benchmarkSort(const AlgorithmInfo& info, const std::vector<int>& input,
+                                 const BenchOptions& options) {
+    size_t n = input.size();
+    BenchResult result{&info, n, 1, n, {}, {}, {}, 0, true};
     
-    void handleEvents() {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                window.close();
-                isRunning = false;
+    PerfCounters perf;
+    bool samplePerf = options.perf && perf.open();
+    
+    std::vector<int> work;
+    for (int rep = 0; rep < options.warmup + options.reps; rep++) {
+        work = input;
+        NullSink sink;
+        
+        if (samplePerf) {
+            perf.start();
+        }
+        auto begin = std::chrono::steady_clock::now();
+        runSort(info.type, work, sink);
+        auto end = std::chrono::steady_clock::now();
+        if (samplePerf) {
+            perf.stop();
+        }
+        
+        if (rep >= options.warmup) {
+            result.millis.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+        }
+    }
+    result.verified = std::is_sorted(work.begin(), work.end());
+    result.perf = perf.read();
+    
+    // Counting every step perturbs timing, so operation counts come from a separate run
+    work = input;
+    if (options.traceFile.empty()) {
+        CountingSink counter;
+        runSort(info.type, work, counter);
+        result.counters = counter.counters;
+    } else {
+        TraceWriter writer;
+        if (openTrace(writer, options.traceFile, info.type, input)) {
+            runSort(info.type, work, writer);
+            writer.finish();
+            result.counters = writer.counters;
+        }
+    }
+    
+    return result;
+}
+
+inline BenchResult benchmarkPathfinding(const AlgorithmInfo& info, const GridMap& grid, const BenchOptions& options) {
+    BenchResult result{&info, static_cast<size_t>(grid.width), 1, grid.cellCount(), {}, {}, {}, 0, true};
+    SearchScratch scratch;
+    
+    PerfCounters perf;
+    bool samplePerf = options.perf && perf.open();
+    
+    for (int rep = 0; rep < options.warmup + options.reps; rep++) {
+        NullSink sink;
+        
+        if (samplePerf) {
+            perf.start();
+        }
+        auto begin = std::chrono::steady_clock::now();
+        runPathfinding(info.type, grid, scratch, sink);
+        auto finish = std::chrono::steady_clock::now();
+        if (samplePerf) {
+            perf.stop();
+        }
+        
+        if (rep >= options.warmup) {
+            result.millis.push_back(std::chrono::duration<double, std::milli>(finish - begin).count());
+        }
+    }
+    
+    result.perf = perf.read();
+    
+    if (options.traceFile.empty()) {
+        CountingSink counter;
+        runPathfinding(info.type, grid, scratch, counter);
+        result.counters = counter.counters;
+    } else {
+        TraceWriter writer;
+        if (openTrace(writer, options.traceFile, info.type, grid)) {
+            runPathfinding(info.type, grid, scratch, writer);
+            writer.finish();
+            result.counters = writer.counters;
+        }
+    }
+    
+    return result;
+}
+
+inline void printBenchResults(const std::vector<BenchResult>& results, const BenchOptions& options) {
+    const char* fields[] = {"algorithm", "distribution", "size", "elements", "threads", "seed", "reps", "mean_ms",
+                            "min_ms", "median_ms", "max_ms", "stddev_ms", "speedup", "ns_per_element", "comparisons", "swaps",
+                            "reads", "writes", "pushes", "pops", "visits", "path_cells", "cycles", "instructions",
+                            "cache_misses", "branch_misses", "peak_rss_kb", "verified"};
+    
+    if (options.csv) {
+        for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++) {
+            std::cout << (f ? "," : "") << fields[f];
+        }
+        std::cout << "\n";
+    } else {
+        std::cout << "[\n";
+    }
+    
+    auto meanOf = [](const std::vector<double>& ms) {
+        double sum = 0;
+        for (double m : ms) {
+            sum += m;
+        }
+        return sum / ms.size();
+    };
+    
+    for (size_t r = 0; r < results.size(); r++) {
+        const BenchResult& result = results[r];
+        const std::vector<double>& ms = result.millis;
+        double mean = meanOf(ms);
+        
+        // Speedup over the serial baseline's single-threaded run at the same size, when measured
+        std::string speedup = options.csv ? "" : "null";
+        AlgorithmType baseline = serialBaseline(result.algorithm->type);
+        for (const BenchResult& other : results) {
+            if (other.algorithm->type == baseline && other.size == result.size && other.threads == 1) {
+                speedup = std::to_string(meanOf(other.millis) / mean);
             }
-            
-            if (event.type == sf::Event::KeyPressed) {
-                switch (event.key.code) {
-                    case sf::Keyboard::Escape:
-                        window.close();
-                        isRunning = false;
-                        break;
-                    
-                    case sf::Keyboard::R:
-                        generateRandomData();
-                        initializeGrid();
-                        isPaused = true;
-                        break;
-                    
-                    case sf::Keyboard::Space:
-                        isPaused = !isPaused;
-                        break;
-                    
-                    case sf::Keyboard::Add:
-                    case sf::Keyboard::Equal:
-                        speed = std::max(10, speed - 10);
-                        break;
-                    
-                    case sf::Keyboard::Subtract:
-                    case sf::Keyboard::Dash:
-                        speed = std::min(200, speed + 10);
-                        break;
-                    
-                    case sf::Keyboard::Num1:
-                        currentAlgorithm = AlgorithmType::BUBBLE_SORT;
-                        generateRandomData();
-                        isPaused = true;
-                        break;
-                    
-                    case sf::Keyboard::Num2:
-                        currentAlgorithm = AlgorithmType::INSERTION_SORT;
-                        generateRandomData();
-                        isPaused = true;
-                        break;
-                    
-                    case sf::Keyboard::Num3:
-                        currentAlgorithm = AlgorithmType::SELECTION_SORT;
-                        generateRandomData();
-                        isPaused = true;
-                        break;
-                    
-                    case sf::Keyboard::Num4:
-                        currentAlgorithm = AlgorithmType::QUICK_SORT;
-                        generateRandomData();
-                        isPaused = true;
-                        break;
-                    
-                    case sf::Keyboard::Num5:
-                        currentAlgorithm = AlgorithmType::MERGE_SORT;
-                        generateRandomData();
-                        isPaused = true;
-                        break;
-                    
-                    case sf::Keyboard::Num6:
-                        currentAlgorithm = AlgorithmType::BFS;
-                        initializeGrid();
-                        isPaused = true;
-                        break;
-                    
-                    case sf::Keyboard::Num7:
-                        currentAlgorithm = AlgorithmType::DFS;
-                        initializeGrid();
-                        isPaused = true;
-                        break;
-                    
-                    case sf::Keyboard::Num8:
-                        currentAlgorithm = AlgorithmType::DIJKSTRA;
-                        initializeGrid();
-                        isPaused = true;
-                        break;
-                }
+        }
+        
+        double variance = 0;
+        for (double m : ms) {
+            variance += (m - mean) * (m - mean);
+        }
+        double stddev = ms.size() > 1 ? std::sqrt(variance / (ms.size() - 1)) : 0;
+        double median = ms.size() % 2 ? ms[ms.size() / 2] : (ms[ms.size() / 2 - 1] + ms[ms.size() / 2]) / 2;
+        
+        std::vector<std::string> values = {
+            std::string("\"") + result.algorithm->key + "\"",
+            std::string("\"") + (result.algorithm->pathfinding ? (options.mapFile.empty() ? gridPatternInfo(options.gridPattern).key : "map")
+                                  : options.arrayFile.empty() ? distributionKey(options.distribution) : "file") + "\"",
+            std::to_string(result.size),
+            std::to_string(result.elements),
+            std::to_string(result.threads),
+            std::to_string(options.seed),
+            std::to_string(ms.size()),
+            std::to_string(mean),
+            std::to_string(ms.front()),
+            std::to_string(median),
+            std::to_string(ms.back()),
+            std::to_string(stddev),
+            speedup,
+            std::to_string(mean * 1e6 / result.elements),
+            std::to_string(result.counters.comparisons),
+            std::to_string(result.counters.swaps),
+            std::to_string(result.counters.reads),
+            std::to_string(result.counters.writes),
+            std::to_string(result.counters.pushes),
+            std::to_string(result.counters.pops),
+            std::to_string(result.counters.visits),
+            std::to_string(result.counters.pathCells),
+            std::to_string(result.perf.cycles),
+            std::to_string(result.perf.instructions),
+            std::to_string(result.perf.cacheMisses),
+            std::to_string(result.perf.branchMisses),
+            result.peakMemoryKB >= 0 ? std::to_string(result.peakMemoryKB) : (options.csv ? "" : "null"),
+            result.verified ? "true" : "false"
+        };
+        
+        if (options.csv) {
+            for (size_t f = 0; f < values.size(); f++) {
+                std::cout << (f ? "," : "") << values[f];
             }
+            std::cout << "\n";
+        } else {
+            std::cout << "  {";
+            for (size_t f = 0; f < values.size(); f++) {
+                std::cout << (f ? ", " : "") << "\"" << fields[f] << "\": " << values[f];
+            }
+            std::cout << (r + 1 < results.size() ? "},\n" : "}\n");
         }
     }
     
-    void runVisualization() {
-        isRunning = true;
-        isPaused = true;  // Start paused
+    if (!options.csv) {
+        std::cout << "]\n";
+    }
+}
+
+inline int runBenchmark(const BenchOptions& options) {
+    std::vector<BenchResult> results;
+    
+    // Files are loaded once and every algorithm runs on the same data
+    std::vector<int> fileArray;
+    GridMap fileGrid;
+    if ((!options.arrayFile.empty() && !loadArrayFile(options.arrayFile, fileArray)) ||
+        (!options.mapFile.empty() && !loadGridFile(options.mapFile, fileGrid))) {
+        return 1;
+    }
+    std::vector<size_t> fileArraySize = {fileArray.size()};
+    std::vector<size_t> fileGridSize = {static_cast<size_t>(fileGrid.width)};
+    
+    for (AlgorithmType type : options.algorithms) {
+        const AlgorithmInfo& info = algorithmInfo(type);
+        const std::vector<size_t>& sizes = info.pathfinding ? (fileGrid.cells.empty() ? options.gridSizes : fileGridSize)
+                                                            : (fileArray.empty() ? options.sizes : fileArraySize);
         
-        while (window.isOpen() && isRunning) {
-            handleEvents();
+        // Serial algorithms ignore the thread limit and run once
+        std::vector<unsigned> threadLimits = isParallel(type) ? options.threads : std::vector<unsigned>{1};
+        
+        for (size_t size : sizes) {
+            bool randomInput = fileArray.empty() && options.distribution == InputDistribution::UNIFORM;
+            if (!info.pathfinding && isQuadratic(type, randomInput) && size > options.quadraticLimit) {
+                std::cerr << "Skipping " << info.key << " at " << size << " elements (above --quadratic-limit"
+                          << (randomInput ? "" : " for this input") << ")" << std::endl;
+                continue;
+            }
             
-            if (currentAlgorithm == AlgorithmType::BFS || 
-                currentAlgorithm == AlgorithmType::DFS || 
-                currentAlgorithm == AlgorithmType::DIJKSTRA) {
-                drawGrid();
+            for (unsigned limit : threadLimits) {
+                threadLimit() = limit;
+                unsigned threads = limit ? limit : std::max(1u, std::thread::hardware_concurrency());
+                std::string shape = !info.pathfinding ? std::to_string(size) + " elements"
+                                  : fileGrid.cells.empty() ? std::to_string(size) + "^2 cells"
+                                  : std::to_string(fileGrid.width) + "x" + std::to_string(fileGrid.height) + " cells";
+                std::cerr << "Running " << info.key << " at " << shape
+                          << (isParallel(type) ? " on up to " + std::to_string(threads) + " threads" : "")
+                          << std::endl;
                 
-                if (!isPaused) {
-                    // Reset grid to initial state before running algorithm
-                    for (int i = 0; i < gridSize; i++) {
-                        for (int j = 0; j < gridSize; j++) {
-                            if (grid[i][j] == 2 || grid[i][j] == 3) {
-                                grid[i][j] = 0;
-                            }
-                        }
+                // The peak covers this configuration's input, its copies and the runs
+                bool measurePeak = resetPeakMemory();
+                BenchResult result;
+                if (info.pathfinding) {
+                    GridMap generated;
+                    if (fileGrid.cells.empty()) {
+                        generateGrid(generated, static_cast<int>(size), static_cast<int>(size), options.gridPattern,
+                                     options.obstaclePercent, options.seed);
                     }
-                    
-                    switch (currentAlgorithm) {
-                        case AlgorithmType::BFS:
-                            bfs();
-                            break;
-                        case AlgorithmType::DFS:
-                            dfs();
-                            break;
-                        case AlgorithmType::DIJKSTRA:
-                            dijkstra();
-                            break;
-                        default:
-                            break;
+                    result = benchmarkPathfinding(info, fileGrid.cells.empty() ? generated : fileGrid, options);
+                } else {
+                    std::vector<int> generated;
+                    if (fileArray.empty()) {
+                        generateArray(generated, size, options.maxValue, options.distribution, options.seed);
                     }
-                    
-                    isPaused = true;
+                    result = benchmarkSort(info, fileArray.empty() ? generated : fileArray, options);
                 }
-            } else {
-                drawArray();
+                std::sort(result.millis.begin(), result.millis.end());
+                result.peakMemoryKB = measurePeak ? peakMemoryKB() : -1;
+                result.threads = threads;
                 
-                if (!isPaused) {
-                    switch (currentAlgorithm) {
-                        case AlgorithmType::BUBBLE_SORT:
-                            bubbleSort();
-                            break;
-                        case AlgorithmType::INSERTION_SORT:
-                            insertionSort();
-                            break;
-                        case AlgorithmType::SELECTION_SORT:
-                            selectionSort();
-                            break;
-                        case AlgorithmType::QUICK_SORT:
-                            quickSort(0, data.size() - 1);
-                            break;
-                        case AlgorithmType::MERGE_SORT:
-                            mergeSort(0, data.size() - 1);
-                            break;
-                        default:
-                            break;
-                    }
-                    
-                    isPaused = true;
+                if (!result.verified) {
+                    std::cerr << info.key << " produced unsorted output at " << size << " elements!" << std::endl;
                 }
-            }
-            
-            // Ensure window doesn't freeze when paused
-            if (isPaused) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                results.push_back(result);
             }
         }
     }
-};
+    threadLimit() = 0;
+    
+    printBenchResults(results, options);
+    
+    // Resetting the high-water mark also resets ru_maxrss, so include the per-run peaks
+    long peak = processPeakMemoryKB();
+    for (const BenchResult& result : results) {
+        peak = std::max(peak, result.peakMemoryKB);
+    }
+    std::cerr << "Peak memory of the whole benchmark: " << peak << " KiB" << std::endl;
+    return 0;
+}
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        BenchOptions options;
+        if (!parseBenchOptions(argc, argv, options)) {
+            printBenchUsage();
+            return 1;
+        }
+        return runBenchmark(options);
+    }
+    
     AlgorithmVisualizer visualizer;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--record") {
+            visualizer.recordTo(argv[i + 1]);
+            continue;
+        }
+        if (arg == "--profile") {
+            visualizer.profileTo(argv[i + 1]);
+            continue;
+        }
+        if (arg == "--seed" && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+            visualizer.setSeed(std::strtoull(argv[i + 1], nullptr, 10));
+            continue;
+        }
+        if (arg == "--dist") {
+            bool known = false;
+            for (const auto& info : DISTRIBUTIONS) {
+                if (info.key == std::string(argv[i + 1])) {
+                    visualizer.setDistribution(info.distribution);
+                    known = true;
+                }
+            }
+            if (known) {
+                continue;
+            }
+        }
+        if (arg == "--grid") {
+            bool known = false;
+            for (const auto& info : GRID_PATTERNS) {
+                if (info.key == std::string(argv[i + 1])) {
+                    visualizer.setGridPattern(info.pattern);
+                    known = true;
+                }
+            }
+            if (known) {
+                continue;
+            }
+        }
+        if (arg == "--cache") {
+            CacheConfig config;
+            if (parseCacheConfig(argv[i + 1], config)) {
+                visualizer.setCacheMode(true, config);
+                continue;
+            }
+        }
+        if (arg == "--race") {
+            std::vector<AlgorithmType> algorithms;
+            std::vector<std::string> keys = splitList(argv[i + 1]);
+            for (const auto& key : keys) {
+                for (const auto& info : ALGORITHMS) {
+                    if (key == info.key) {
+                        algorithms.push_back(info.type);
+                    }
+                }
+            }
+            if (!algorithms.empty() && algorithms.size() == keys.size()) {
+                visualizer.race(algorithms);
+                continue;
+            }
+        }
+        bool loaded = arg == "--array" ? visualizer.loadArray(argv[i + 1])
+                    : arg == "--map" ? visualizer.loadGrid(argv[i + 1])
+                    : arg == "--replay" ? visualizer.loadReplay(argv[i + 1])
+                    : false;
+        if (!loaded) {
+            std::cerr << "Usage: algorithm_visualizer [--array FILE.i32|FILE.i64] [--map FILE.map|FILE.pgm]\n"
+                         "                            [--record TRACE] [--replay TRACE] [--race ALGO,ALGO,...]\n"
+                         "                            [--profile TIMELINE.json] [--seed N] [--dist NAME]\n"
+                         "                            [--grid NAME] [--cache L1_KB:WAYS,L2_KB:WAYS[,LINE]]\n"
+                         "       algorithm_visualizer --bench [options]" << std::endl;
+            return 1;
+        }
+    }
     visualizer.runVisualization();
     
     return 0;